@@ -14,6 +14,9 @@ const BADGE_TEXT_PARSE_ERROR = 'PARSE';
 const BADGE_TEXT_RULES_ERROR = 'RULES';
 const BADGE_TEXT_EMPTY_LIST = 'EMPTY';
 
+// Höchstzahl dynamischer Regeln (Chrome-Limit), Budget für den Parser
+const DNR_MAX_RULES = chrome.declarativeNetRequest.MAX_NUMBER_OF_DYNAMIC_AND_SESSION_RULES || 5000;
+
 // === Globale Zustandsvariablen ===
 let wasmInitPromise = null;
 let isInitializing = false; // Lock, um parallele Initialisierungen zu verhindern
@@ -125,7 +128,7 @@ function parseListWithWasm(module, filterListText) {
   console.time(`${LOG_PREFIX} WASM Parsing`);
   let jsonString;
   try {
-      jsonString = module.parseFilterListWasm(filterListText);
+      jsonString = module.parseFilterListWasm(filterListText, DNR_MAX_RULES);
   } catch (wasmError) {
       console.error(`${LOG_PREFIX} Error calling WASM function:`, wasmError);
       throw new Error(`WASM Execution Error: ${wasmError.message}`);
@@ -133,12 +136,82 @@ function parseListWithWasm(module, filterListText) {
       console.timeEnd(`${LOG_PREFIX} WASM Parsing`);
   }
 
+  return decodeWasmResult(jsonString);
+}
+
+/**
+ * Holt die Filterliste gestreamt und füttert die Stücke direkt in den
+ * inkrementellen WASM-Parser (FilterListParser). Parsen und Download
+ * überlappen, und der komplette Text liegt nie als JS-String vor.
+ * @param {object} module - Das initialisierte WASM-Modul.
+ * @returns {Promise<object>} Ergebnisobjekt mit rules und stats.
+ * @throws {Error} Wenn Fetch oder Parsen fehlschlägt.
+ */
+async function fetchAndParseStreaming(module) {
+  const url = chrome.runtime.getURL(FILTER_LIST_URL);
+  console.log(`${LOG_PREFIX} Streaming filter list from ${url}`);
+
+  let reader;
+  try {
+    const resp = await fetch(url);
+    if (!resp.ok) {
+      throw new Error(`Fetch failed with status: ${resp.status} ${resp.statusText}`);
+    }
+    reader = resp.body.getReader();
+  } catch (error) {
+    console.error(`${LOG_PREFIX} Error during fetch:`, error);
+    throw new Error(`Fetch Error: ${error.message}`);
+  }
+
+  console.time(`${LOG_PREFIX} WASM Streaming Parse`);
+  const parser = new module.FilterListParser();
+  // Regeln über dem DNR-Limit wählt der Parser nach Nutzen aus, statt
+  // dass updateRules() das Ende der Liste abschneidet
+  if (typeof parser.setMaxRules === 'function') {
+    parser.setMaxRules(DNR_MAX_RULES);
+  }
+  let jsonString;
+  let bytes = 0;
+  try {
+    for (;;) {
+      let chunk;
+      try {
+        chunk = await reader.read();
+      } catch (error) {
+        throw new Error(`Fetch Error: ${error.message}`);
+      }
+      if (chunk.done) break;
+      bytes += chunk.value.length;
+      // embind akzeptiert Uint8Array für std::string – keine Dekodierung nötig
+      parser.feed(chunk.value);
+    }
+    jsonString = parser.finish();
+  } catch (error) {
+    console.error(`${LOG_PREFIX} Error during streaming parse:`, error);
+    if (error.message.startsWith('Fetch Error')) throw error;
+    throw new Error(`WASM Execution Error: ${error.message}`);
+  } finally {
+    parser.delete();
+    console.timeEnd(`${LOG_PREFIX} WASM Streaming Parse`);
+  }
+  console.log(`${LOG_PREFIX} Streamed filter list (${bytes} bytes).`);
+
+  return decodeWasmResult(jsonString);
+}
+
+/**
+ * Dekodiert und prüft das JSON-Ergebnis des WASM-Parsers.
+ * @param {string} jsonString - Rückgabe von parseFilterListWasm bzw. FilterListParser.finish.
+ * @returns {object} Ergebnisobjekt mit rules und stats.
+ * @throws {Error} Wenn das JSON ungültig ist oder die Struktur nicht passt.
+ */
+function decodeWasmResult(jsonString) {
   if (!jsonString) {
     // Kann passieren, wenn die Liste leer ist oder nur Kommentare enthält
     console.warn(`${LOG_PREFIX} WASM parser returned empty or null string. Assuming empty rule set.`);
     // Wir geben ein leeres Regelset zurück, anstatt einen Fehler zu werfen
     // Die Behandlung erfolgt dann in initialize()
-    return { rules: [], stats: { totalLines: 0, processedRules: 0, skippedLines: 0 } };
+    return { rules: [], stats: { totalLines: 0, processedRules: 0, skippedLines: 0, duplicateRules: 0, loweredRegexRules: 0, rejectedRegexRules: 0, droppedRules: 0, shadowedRules: 0, subsumedRules: 0, coalescedRules: 0 } };
   }
 
   let result;
@@ -159,8 +232,27 @@ function parseListWithWasm(module, filterListText) {
     `${LOG_PREFIX} Parsed ${result.rules.length} rules. Stats: ` +
     `totalLines=${result.stats.totalLines}, ` +
     `processed=${result.stats.processedRules}, ` +
-    `skipped=${result.stats.skippedLines}`
+    `skipped=${result.stats.skippedLines}, ` +
+    `loweredRegex=${result.stats.loweredRegexRules ?? 0}, ` +
+    `rejectedRegex=${result.stats.rejectedRegexRules ?? 0}, ` +
+    `duplicates=${result.stats.duplicateRules ?? 0}, ` +
+    `shadowed=${result.stats.shadowedRules ?? 0}, ` +
+    `subsumed=${result.stats.subsumedRules ?? 0}, ` +
+    `coalesced=${result.stats.coalescedRules ?? 0}, ` +
+    `dropped=${result.stats.droppedRules ?? 0}`
   );
+  if (result.regexReport?.length) {
+    console.warn(
+      `${LOG_PREFIX} Dropped ${result.regexReport.length} regex rules Chrome would reject: ` +
+      result.regexReport.slice(0, 10).map(r => `line ${r.line} (${r.reason})`).join(', ')
+    );
+  }
+  if (result.budgetReport && result.stats.droppedRules > 0) {
+    console.warn(
+      `${LOG_PREFIX} Rule budget exceeded: dropped ${result.stats.droppedRules} rules, ` +
+      `estimated coverage loss ${(result.budgetReport.coverageLoss * 100).toFixed(1)}%`
+    );
+  }
   return result; // Gibt das ganze Objekt zurück, inkl. Stats
 }
 
@@ -184,11 +276,18 @@ async function initialize() {
     // 1. WASM-Modul laden/sicherstellen
     const wasmModule = await ensureWasmModuleLoaded();
 
-    // 2. Filterliste abrufen
-    const listText = await fetchFilterList();
-
-    // 3. Liste mit WASM parsen
-    const parseResult = parseListWithWasm(wasmModule, listText);
+    // 2./3. Filterliste abrufen und mit WASM parsen – gestreamt, falls das
+    // Modul den inkrementellen Parser exportiert, sonst am Stück
+    let parseResult;
+    if (typeof wasmModule.FilterListParser === 'function') {
+      parseResult = await fetchAndParseStreaming(wasmModule);
+    } else {
+      // filter_parser.js/.wasm stammt noch aus der Zeit vor FilterListParser
+      console.warn(`${LOG_PREFIX} WASM module has no FilterListParser, parsing the whole list at once ` +
+                   `(rebuild wasm/filter_parser.js with 'make wasm').`);
+      const listText = await fetchFilterList();
+      parseResult = parseListWithWasm(wasmModule, listText);
+    }
     const rules = parseResult.rules;
     const stats = parseResult.stats; // Statistiken extrahieren
 
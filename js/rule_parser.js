@@ -60,8 +60,10 @@ export async function updateRules(rules) {
 const DNR_MAX_RULES = chrome.declarativeNetRequest.MAX_NUMBER_OF_DYNAMIC_AND_SESSION_RULES || 5000;
 let toAdd = rules;
 
+// Das Budget wählt schon der WASM-Parser nach Nutzen aus; abgeschnitten
+// wird nur noch, wenn ein veraltetes filter_parser.wasm es nicht kennt
 if (rules.length > DNR_MAX_RULES) {
-  console.warn(`Truncating from ${rules.length} to ${DNR_MAX_RULES} rules`);
+  console.warn(`Parser ignored the rule budget, truncating from ${rules.length} to ${DNR_MAX_RULES} rules`);
   toAdd = rules.slice(0, DNR_MAX_RULES);
 }
 
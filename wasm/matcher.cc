@@ -0,0 +1,689 @@
+/***********************************************************************
+ *  Offline-Matcher für DnrRules (siehe matcher.h)
+ ***********************************************************************/
+
+#include "matcher.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+/* ------------------------------------------------------------------ *
+ *  Hilfs-Utilities
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr size_t   NPOS       = std::string_view::npos;
+constexpr uint32_t NO_RULE    = UINT32_MAX;
+constexpr int32_t  NO_REGEX   = INT32_MIN;      // Regel ohne regexFilter
+
+// Ohne resourceTypes greift eine Regel für alles außer main_frame
+constexpr ResourceTypeMask DEFAULT_RESOURCE_TYPES =
+    ALL_RESOURCE_TYPES_MASK & ~resource_type_bit(ResourceType::MainFrame);
+
+constexpr char ascii_lower(char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; }
+
+// Weder Buchstabe noch Ziffer noch '_', '-', '.', '%' (erwartet Kleinbuchstaben)
+constexpr std::array<bool, 256> SEPARATOR = [] {
+    std::array<bool, 256> t{};
+    for (int c = 0; c < 256; ++c)
+        t[c] = !((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' ||
+                 c == '%');
+    for (int c = 'A'; c <= 'Z'; ++c) t[c] = false;
+    return t;
+}();
+
+constexpr bool is_separator(char c) { return SEPARATOR[static_cast<unsigned char>(c)]; }
+
+// Token = maximale Folge aus Buchstaben und Ziffern; alles andere
+// (auch jedes Trennzeichen, das '^' treffen kann) beendet eines
+constexpr bool is_token_char(char c) { return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'); }
+
+// FNV-1a, Zeichen für Zeichen beim Durchlaufen der URL; 0 bleibt als
+// "leer" frei
+constexpr uint64_t TOKEN_SEED = 0xCBF29CE484222325ull;
+constexpr uint64_t token_step(uint64_t h, char c) {
+    return (h ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+}
+constexpr uint64_t token_key(uint64_t h) { return h | 1; }
+
+uint64_t token_hash(std::string_view token) {
+    uint64_t h = TOKEN_SEED;
+    for (const char c : token) h = token_step(h, c);
+    return token_key(h);
+}
+
+// Ruft fn(hash) für jedes Token von s auf (s klein geschrieben)
+template <typename Fn>
+void for_each_token(std::string_view s, Fn &&fn) {
+    uint64_t h   = TOKEN_SEED;
+    bool     run = false;
+    for (const char c : s) {
+        if (is_token_char(c)) {
+            h   = token_step(h, c);
+            run = true;
+        } else if (run) {
+            fn(token_key(h));
+            h   = TOKEN_SEED;
+            run = false;
+        }
+    }
+    if (run) fn(token_key(h));
+}
+
+constexpr bool is_host_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_';
+}
+
+// Host als [begin, end) hinter "scheme://" (ohne Userinfo und Port)
+std::pair<size_t, size_t> host_range(std::string_view url) {
+    size_t begin = url.find("://");
+    if (begin == NPOS) return {0, 0};
+    begin += 3;
+    size_t end = url.find_first_of("/?#", begin);
+    if (end == NPOS) end = url.size();
+    const size_t at = url.substr(begin, end - begin).rfind('@');
+    if (at != NPOS) begin += at + 1;
+    if (begin >= end) return {begin, begin};                                    // leerer Host
+    const size_t from  = url[begin] == '[' ? url.find(']', begin) : begin;     // IPv6-Literal
+    const size_t colon = from == NPOS ? NPOS : url.substr(from, end - from).find(':');
+    if (colon != NPOS) end = from + colon;
+    return {begin, end};
+}
+
+constexpr size_t label_count(std::string_view host) {
+    return static_cast<size_t>(std::count(host.begin(), host.end(), '.')) + 1;
+}
+
+// Host eines Origins ("https://a.com") oder schon ein Host ("a.com:8080")
+std::string_view initiator_host(std::string_view initiator) {
+    if (initiator.find("://") != NPOS) {
+        const auto [begin, end] = host_range(initiator);
+        return initiator.substr(begin, end - begin);
+    }
+    return initiator.substr(0, initiator.find_first_of(":/"));
+}
+
+RequestMethodMask method_bit(std::string_view m) {
+    for (size_t b = 0; b < SUPPORTED_METHODS.size(); ++b) {
+        const std::string_view name = SUPPORTED_METHODS[b];
+        if (name.size() == m.size() &&
+            std::equal(name.begin(), name.end(), m.begin(),
+                       [](char n, char c) { return n == (c >= 'a' && c <= 'z' ? char(c - 'a' + 'A') : c); }))
+            return static_cast<RequestMethodMask>(1u << b);
+    }
+    return 0;
+}
+
+// Vorrang bei gleicher Priorität (Chrome: allow vor allowAllRequests
+// vor block vor upgradeScheme vor redirect vor modifyHeaders)
+uint64_t action_rank(std::string_view action) {
+    static constexpr std::string_view ORDER[] = {"modifyHeaders", "redirect", "upgradeScheme",
+                                                 "block", "allowAllRequests", "allow"};
+    for (size_t i = 0; i < std::size(ORDER); ++i)
+        if (ORDER[i] == action) return i;
+    return 0;
+}
+
+}  // namespace
+
+/* ------------------------------------------------------------------ *
+ *  urlFilter
+ *
+ *  Das Muster zerfällt an den '*' in Segmente.  Das erste Segment sitzt
+ *  am Anker (URL-Anfang bzw. Label-Anfang im Host), jedes weitere am
+ *  frühesten Treffer hinter dem vorigen – ein früheres Ende lässt für
+ *  den Rest nie weniger Möglichkeiten.  Mit rechtem Anker muss das
+ *  letzte Segment am URL-Ende enden.  '^' trifft ein Trennzeichen oder,
+ *  wenn danach nur noch '^' folgen, das URL-Ende.  Muster und URL sind
+ *  klein geschrieben.
+ * ------------------------------------------------------------------ */
+
+struct RuleMatcher::UrlPattern {
+    enum class Anchor : uint8_t { None, Left, Domain };
+
+    std::string                                body;          // ohne Anker
+    std::vector<std::pair<uint32_t, uint32_t>> segments;      // [begin, end) in body
+    Anchor                                     anchor      = Anchor::None;
+    bool                                       rightAnchor = false;
+
+    explicit UrlPattern(std::string_view filter) {
+        if (filter.starts_with("||"))     anchor = Anchor::Domain, filter.remove_prefix(2);
+        else if (filter.starts_with('|')) anchor = Anchor::Left, filter.remove_prefix(1);
+        if (!filter.empty() && filter.back() == '|') rightAnchor = true, filter.remove_suffix(1);
+        body.resize(filter.size());
+        std::transform(filter.begin(), filter.end(), body.begin(), ascii_lower);
+        size_t begin = 0;
+        for (size_t i = 0; i <= body.size(); ++i) {
+            if (i < body.size() && body[i] != '*') continue;
+            segments.emplace_back(static_cast<uint32_t>(begin), static_cast<uint32_t>(i));
+            begin = i + 1;
+        }
+    }
+
+    std::string_view segment(size_t i) const {
+        return std::string_view(body).substr(segments[i].first, segments[i].second - segments[i].first);
+    }
+
+    // Host-Anker "||host/" bzw. "||host^": host, sonst leer
+    std::string_view anchored_host() const {
+        if (anchor != Anchor::Domain) return {};
+        const std::string_view s = segment(0);
+        size_t                 n = 0;
+        while (n < s.size() && is_host_char(s[n])) ++n;
+        if (n == 0 || n == s.size() || (s[n] != '/' && s[n] != '^')) return {};
+        if (s.front() == '.' || s[n - 1] == '.') return {};
+        return s.substr(0, n);
+    }
+
+    // Segment ab url[pos]: Ende oder NPOS
+    static size_t match_segment(std::string_view seg, std::string_view url, size_t pos) {
+        for (size_t k = 0; k < seg.size(); ++k, ++pos) {
+            if (pos == url.size())
+                return seg.find_first_not_of('^', k) == NPOS ? pos : NPOS;
+            if (seg[k] == '^' ? !is_separator(url[pos]) : seg[k] != url[pos]) return NPOS;
+        }
+        return pos;
+    }
+
+    // Frühester Treffer ab from: Ende oder NPOS
+    static size_t find_segment(std::string_view seg, std::string_view url, size_t from) {
+        if (seg.empty()) return from;
+        for (size_t p = from; p <= url.size(); ++p) {
+            if (seg[0] != '^') {
+                p = url.find(seg[0], p);
+                if (p == NPOS) return NPOS;
+            }
+            if (const size_t end = match_segment(seg, url, p); end != NPOS) return end;
+        }
+        return NPOS;
+    }
+
+    // Segment endet genau am URL-Ende und beginnt nicht vor from
+    static bool ends_at_end(std::string_view seg, std::string_view url, size_t from) {
+        const size_t trailing = seg.size() - (seg.find_last_not_of('^') + 1);
+        for (size_t k = 0; k <= trailing; ++k) {
+            const size_t width = seg.size() - k;                // k '^' treffen das Ende
+            if (width > url.size() || url.size() - width < from) continue;
+            if (match_segment(seg, url, url.size() - width) == url.size()) return true;
+        }
+        return false;
+    }
+
+    // Segmente ab i, jedes mit '*' davor, ab Position pos
+    bool tail(std::string_view url, size_t i, size_t pos) const {
+        for (; i < segments.size(); ++i) {
+            if (rightAnchor && i + 1 == segments.size()) return ends_at_end(segment(i), url, pos);
+            pos = find_segment(segment(i), url, pos);
+            if (pos == NPOS) return false;
+        }
+        return true;
+    }
+
+    bool matches_from(std::string_view url, size_t start) const {
+        const size_t end = match_segment(segment(0), url, start);
+        if (end == NPOS) return false;
+        if (segments.size() == 1) return !rightAnchor || end == url.size();
+        return tail(url, 1, end);
+    }
+
+    // Ruft fn(token) für jedes Token des Musters auf, das in jeder
+    // getroffenen URL als ganzes Token vorkommt: links und rechts
+    // begrenzt durch ein wörtliches Nicht-Token-Zeichen, '^' oder einen
+    // Anker – nicht durch '*' oder ein offenes Musterende
+    template <typename Fn>
+    void for_each_key_token(Fn &&fn) const {
+        auto bounded = [&](size_t i, bool atEnd, bool anchored) {
+            return atEnd ? anchored : body[i] != '*' && !is_token_char(body[i]);
+        };
+        for (size_t i = 0; i < body.size();) {
+            if (!is_token_char(body[i])) {
+                ++i;
+                continue;
+            }
+            size_t end = i;
+            while (end < body.size() && is_token_char(body[end])) ++end;
+            if (bounded(i - 1, i == 0, anchor != Anchor::None) &&
+                bounded(end, end == body.size(), rightAnchor))
+                fn(std::string_view(body).substr(i, end - i));
+            i = end;
+        }
+    }
+
+    bool matches(std::string_view url, size_t hostBegin, size_t hostEnd) const {
+        switch (anchor) {
+            case Anchor::None:
+                return tail(url, 0, 0);
+            case Anchor::Left:
+                return matches_from(url, 0);
+            case Anchor::Domain:
+                for (size_t s = hostBegin; s < hostEnd; ++s)
+                    if ((s == hostBegin || url[s - 1] == '.') && matches_from(url, s)) return true;
+                return false;
+        }
+        return false;
+    }
+};
+
+bool url_filter_matches(std::string_view filter, std::string_view url) {
+    std::string lower(url);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ascii_lower);
+    const auto [begin, end] = host_range(lower);
+    return RuleMatcher::UrlPattern(filter).matches(lower, begin, end);
+}
+
+/* ------------------------------------------------------------------ *
+ *  Host-Suffix-Index
+ *
+ *  Der Hash läuft labelweise von rechts nach links: der Zustand nach
+ *  "c" und "b" ist der Hash von "b.c", ein weiteres Label macht daraus
+ *  den von "a.b.c".  Jedes Label wird 8 Bytes je Schritt gehasht, die
+ *  Kette über den Host ist also nur eine Multiplikation je Label lang.
+ *  Vor der Sonde mischt ein Finalizer die Bits; Slot = untere Bits,
+ *  obere Bits zum Vorfiltern im Slot.  Bei gleichem Hash entscheidet
+ *  der Text im Eintrag.
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr uint64_t HASH_MUL = 0x9E3779B97F4A7C15ull;
+
+uint64_t label_hash(const char *p, size_t n) {
+    uint64_t h = n;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = (h ^ w) * HASH_MUL;
+    }
+    uint64_t w = 0;
+    for (size_t k = 0; k < n; ++k) w |= uint64_t(static_cast<unsigned char>(p[k])) << (8 * k);
+    return (h ^ w) * HASH_MUL;
+}
+
+constexpr uint64_t suffix_key(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 33);
+}
+
+// Ruft fn(key, start) für jedes nicht-leere Label-Suffix host[start..]
+// auf, das kürzeste zuerst; betrachtet höchstens max Labels
+template <typename Fn>
+void for_each_suffix_key(std::string_view host, size_t max, Fn &&fn) {
+    uint64_t h   = 0;
+    size_t   end = host.size();
+    for (size_t n = 0; n < max; ++n) {
+        size_t begin = end;
+        while (begin > 0 && host[begin - 1] != '.') --begin;
+        h = (h ^ label_hash(host.data() + begin, end - begin)) * HASH_MUL;
+        if (begin < host.size()) fn(suffix_key(h), begin);
+        if (begin == 0) return;
+        end = begin - 1;
+    }
+}
+
+}  // namespace
+
+void HostSuffixIndex::build(const DomainTable &domains) {
+    std::vector<uint64_t> keys(domains.size());
+    std::vector<uint32_t> refs(domains.size());
+    entries_.clear();
+    for (DomainId id = 0; id < domains.size(); ++id) {
+        const std::string_view d = domains[id];
+        for_each_suffix_key(d, SIZE_MAX, [&](uint64_t k, size_t) { keys[id] = k; });
+        refs[id] = static_cast<uint32_t>(entries_.size()) + 1;
+        entries_.push_back(id);
+        entries_.push_back(static_cast<uint32_t>(d.size()));
+        entries_.resize(entries_.size() + (d.size() + 3) / 4);
+        std::memcpy(entries_.data() + refs[id] + 1, d.data(), d.size());
+    }
+    refMask_ = 1;
+    while (refMask_ <= entries_.size()) refMask_ = refMask_ << 1 | 1;
+
+    size_t capacity = 16;
+    while (capacity < domains.size() * 2) capacity *= 2;
+    slots_.assign(capacity, 0);
+    const size_t mask = capacity - 1;
+    for (DomainId id = 0; id < domains.size(); ++id) {
+        size_t slot = keys[id] & mask;
+        while (slots_[slot] != 0) slot = (slot + 1) & mask;
+        slots_[slot] = (static_cast<uint32_t>(keys[id] >> 32) & ~refMask_) | refs[id];
+    }
+}
+
+// Erst die Schlüssel berechnen und ihre Slots vorab laden, dann
+// sondieren: die Speicherzugriffe der Labels überlappen sich.  Längere
+// Hosts laufen in mehreren Runden
+size_t HostSuffixIndex::lookup(std::string_view host, DomainId *ids, size_t max) const {
+    if (slots_.empty()) return 0;
+    constexpr size_t BATCH = 128;               // ein 253-Zeichen-Host hat höchstens 127 Labels
+    uint64_t         keys[BATCH];
+    uint32_t         starts[BATCH];
+    const size_t     mask  = slots_.size() - 1;
+    size_t           n     = 0;
+    size_t           count = 0;
+    const auto       probe = [&] {
+        for (size_t k = 0; k < n; ++k) {
+            const uint32_t         tag    = static_cast<uint32_t>(keys[k] >> 32) & ~refMask_;
+            const std::string_view suffix = host.substr(starts[k]);
+            for (size_t slot = keys[k] & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+                if ((slots_[slot] & ~refMask_) != tag) continue;
+                const uint32_t *e = entries_.data() + (slots_[slot] & refMask_) - 1;
+                if (e[1] == suffix.size() && std::memcmp(e + 2, suffix.data(), suffix.size()) == 0) {
+                    ids[count++] = e[0];
+                    break;
+                }
+            }
+        }
+        n = 0;
+    };
+    for_each_suffix_key(host, max, [&](uint64_t key, size_t start) {
+        keys[n]   = key;
+        starts[n] = static_cast<uint32_t>(start);
+        __builtin_prefetch(&slots_[key & mask]);
+        if (++n == BATCH) probe();
+    });
+    probe();
+    return count;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Aufbau
+ * ------------------------------------------------------------------ */
+
+struct RuleMatcher::Entry {
+    uint64_t          rank = 0;                 // Priorität, dann Aktion
+    ResourceTypeMask  types = 0;                // effektiv
+    RequestMethodMask methods = 0, excludedMethods = 0;
+    ListRef           requestDomains, excludedRequestDomains, initiatorDomains, excludedInitiatorDomains;
+    int32_t           pattern = -1;
+    int32_t           regex = NO_REGEX;             // Nummer in regexes_, -1: nicht übersetzbar
+};
+
+RuleMatcher::RuleMatcher(std::span<const DnrRule> rules, const DomainTable &domains) : rules_(rules) {
+    std::vector<DomainId> hostOf(domains.size(), NO_DOMAIN);   // Tabelle der Regeln → hosts_
+    auto host_id = [&](DomainId d) {
+        if (hostOf[d] == NO_DOMAIN) hostOf[d] = hosts_.intern(domains[d]);
+        return hostOf[d];
+    };
+    auto add_list = [&](DomainList list) {
+        ListRef ref{static_cast<uint32_t>(listPool_.size()), static_cast<uint32_t>(list.size())};
+        for (const DomainId d : list) listPool_.push_back(host_id(d));
+        std::sort(listPool_.begin() + ref.offset, listPool_.end());
+        return ref;
+    };
+
+    std::vector<std::pair<DomainId, uint32_t>> hostPairs, initiatorPairs;
+    std::vector<uint32_t>                      genericPatterns;
+    entries_.reserve(rules.size());
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const DnrRule &r   = rules[i];
+        const auto     idx = static_cast<uint32_t>(i);
+        Entry         &e   = entries_.emplace_back();
+        e.rank  = uint64_t(static_cast<uint32_t>(r.priority)) << 8 | action_rank(r.actionType);
+        e.types = r.conditionResourceTypes ? r.conditionResourceTypes : DEFAULT_RESOURCE_TYPES;
+        e.methods                  = r.conditionRequestMethods;
+        e.excludedMethods          = r.conditionExcludedRequestMethods;
+        e.requestDomains           = add_list(r.conditionRequestDomains);
+        e.excludedRequestDomains   = add_list(r.conditionExcludedRequestDomains);
+        e.initiatorDomains         = add_list(r.conditionInitiatorDomains);
+        e.excludedInitiatorDomains = add_list(r.conditionExcludedInitiatorDomains);
+
+        std::string_view anchorHost;
+        if (r.conditionUrlFilter) {
+            e.pattern  = static_cast<int32_t>(patterns_.size());
+            anchorHost = patterns_.emplace_back(*r.conditionUrlFilter).anchored_host();
+        }
+        if (r.conditionRegexFilter) {
+            e.regex = regexes_.add(*r.conditionRegexFilter);
+            if (e.regex < 0) ++stats_.badRegex;
+        }
+
+        // Einordnen: Request-Host vor Initiator vor generisch
+        if (!r.conditionRequestDomains.empty()) {
+            for (const DomainId d : r.conditionRequestDomains) hostPairs.emplace_back(host_id(d), idx);
+            ++stats_.hostIndexed;
+        } else if (!anchorHost.empty()) {
+            hostPairs.emplace_back(hosts_.intern(anchorHost), idx);
+            ++stats_.hostIndexed;
+        } else if (!r.conditionInitiatorDomains.empty()) {
+            for (const DomainId d : r.conditionInitiatorDomains) initiatorPairs.emplace_back(host_id(d), idx);
+            ++stats_.initiatorIndexed;
+        } else if (r.conditionRegexFilter) {
+            generic_.push_back(idx);
+            ++stats_.regex;
+        } else if (r.conditionUrlFilter) {
+            genericPatterns.push_back(idx);
+        } else {
+            generic_.push_back(idx);
+            ++stats_.generic;
+        }
+    }
+    build_buckets(byHost_, hosts_.size(), hostPairs);
+    build_buckets(byInitiator_, hosts_.size(), initiatorPairs);
+    build_token_index(genericPatterns);
+    suffixes_.build(hosts_);
+    regexes_.build();
+}
+
+RuleMatcher::~RuleMatcher() = default;
+
+// Zählsortierung nach ID; innerhalb einer ID bleibt die
+// Regel-Reihenfolge erhalten
+void RuleMatcher::build_buckets(Buckets &b, size_t ids,
+                                const std::vector<std::pair<uint32_t, uint32_t>> &pairs) {
+    b.start.assign(ids + 1, 0);
+    for (const auto &[id, rule] : pairs) ++b.start[id + 1];
+    for (size_t h = 1; h < b.start.size(); ++h) b.start[h] += b.start[h - 1];
+    b.rules.resize(pairs.size());
+    std::vector<uint32_t> fill(b.start.begin(), b.start.end() - 1);
+    for (const auto &[id, rule] : pairs) b.rules[fill[id]++] = rule;
+}
+
+// Jede Regel hängt an dem ihrer Schlüssel-Token, das die wenigsten
+// generischen Regeln haben; Tokens, die fast jede URL enthält, nur
+// notfalls.  Gleich häufig: das längere.
+void RuleMatcher::build_token_index(const std::vector<uint32_t> &rules) {
+    static constexpr std::string_view COMMON[] = {"http", "https", "www", "com"};
+    std::unordered_map<uint64_t, uint32_t> frequency;
+    for (const uint32_t rule : rules) {
+        patterns_[entries_[rule].pattern].for_each_key_token(
+            [&](std::string_view t) { ++frequency[token_hash(t)]; });
+    }
+    for (const std::string_view t : COMMON)
+        if (const auto it = frequency.find(token_hash(t)); it != frequency.end()) it->second += 1u << 30;
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;       // (Token-ID, Regel)
+    std::vector<uint64_t>                      hashes;      // je Token-ID
+    std::unordered_map<uint64_t, uint32_t>     ids;
+    for (const uint32_t rule : rules) {
+        uint64_t best = 0;
+        uint32_t bestCount = UINT32_MAX;
+        size_t   bestLength = 0;
+        patterns_[entries_[rule].pattern].for_each_key_token([&](std::string_view t) {
+            const uint64_t h = token_hash(t);
+            const uint32_t n = frequency[h];
+            if (n < bestCount || (n == bestCount && t.size() > bestLength))
+                best = h, bestCount = n, bestLength = t.size();
+        });
+        if (!best) {
+            generic_.push_back(rule);
+            ++stats_.generic;
+            continue;
+        }
+        const auto [it, added] = ids.emplace(best, static_cast<uint32_t>(hashes.size()));
+        if (added) hashes.push_back(best);
+        pairs.emplace_back(it->second, rule);
+        ++stats_.tokenIndexed;
+    }
+    build_buckets(byToken_, hashes.size(), pairs);
+
+    size_t capacity = 16;
+    while (capacity < hashes.size() * 2) capacity *= 2;
+    tokens_.keys.assign(capacity, 0);
+    tokens_.ids.assign(capacity, 0);
+    for (uint32_t id = 0; id < hashes.size(); ++id) {
+        size_t slot = hashes[id] & (capacity - 1);
+        while (tokens_.keys[slot]) slot = (slot + 1) & (capacity - 1);
+        tokens_.keys[slot] = hashes[id];
+        tokens_.ids[slot]  = id;
+    }
+}
+
+uint32_t RuleMatcher::token_id(uint64_t hash) const {
+    const size_t mask = tokens_.keys.size() - 1;
+    for (size_t slot = hash & mask; tokens_.keys[slot]; slot = (slot + 1) & mask)
+        if (tokens_.keys[slot] == hash) return tokens_.ids[slot];
+    return NO_RULE;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Abfrage
+ * ------------------------------------------------------------------ */
+
+struct RuleMatcher::Query {
+    std::string       url;                      // klein geschrieben
+    size_t            hostBegin = 0, hostEnd = 0;
+    std::vector<DomainId> hostIds;              // bekannte Suffixe des Hosts, Platz je Label
+    size_t            hostCount = 0;
+    std::string       initiatorHost;            // klein geschrieben
+    std::vector<DomainId> initiatorIds;
+    size_t            initiatorCount = 0;
+    bool              hasInitiator   = false;
+    ResourceTypeMask  type           = 0;
+    RequestMethodMask method         = 0;       // 0 = unbekannte Methode
+    std::vector<uint64_t> tokens;               // Token-Hashes der URL, ohne Doppelte
+    std::vector<uint64_t> regexHits;            // je regexFilter ein Bit, beim ersten Bedarf
+    bool                  regexDone = false;
+    MatchCost         cost;
+};
+
+void RuleMatcher::prepare(Query &q, std::string_view url, std::string_view initiator, ResourceType type,
+                          std::string_view method) const {
+    q.url.resize(url.size());
+    std::transform(url.begin(), url.end(), q.url.begin(), ascii_lower);
+    std::tie(q.hostBegin, q.hostEnd) = host_range(q.url);
+    q.type   = resource_type_bit(type);
+    q.method = method_bit(method);
+
+    // Suffixe, die in keiner Liste und keinem Anker vorkommen, können
+    // nichts treffen und fallen hier schon weg
+    const std::string_view host = std::string_view(q.url).substr(q.hostBegin, q.hostEnd - q.hostBegin);
+    q.hostIds.resize(label_count(host));
+    q.hostCount    = suffixes_.lookup(host, q.hostIds.data(), q.hostIds.size());
+    q.hasInitiator = !initiator.empty();
+    if (q.hasInitiator) {
+        const std::string_view h = initiator_host(initiator);
+        q.initiatorHost.resize(h.size());
+        std::transform(h.begin(), h.end(), q.initiatorHost.begin(), ascii_lower);
+        q.initiatorIds.resize(label_count(q.initiatorHost));
+        q.initiatorCount = suffixes_.lookup(q.initiatorHost, q.initiatorIds.data(), q.initiatorIds.size());
+    }
+
+    if (!byToken_.rules.empty()) {
+        for_each_token(q.url, [&](uint64_t h) { q.tokens.push_back(h); });
+        std::sort(q.tokens.begin(), q.tokens.end());
+        q.tokens.erase(std::unique(q.tokens.begin(), q.tokens.end()), q.tokens.end());
+    }
+}
+
+bool RuleMatcher::in_list(ListRef list, std::span<const DomainId> suffixes) const {
+    const DomainId *begin = listPool_.data() + list.offset, *end = begin + list.size;
+    for (const DomainId id : suffixes) {
+        if (list.size <= 8 ? std::find(begin, end, id) != end : std::binary_search(begin, end, id))
+            return true;
+    }
+    return false;
+}
+
+bool RuleMatcher::verify(uint32_t rule, Query &q) const {
+    const Entry &e = entries_[rule];
+    if (!(e.types & q.type)) return false;
+    if (q.method ? (e.methods && !(e.methods & q.method)) || (e.excludedMethods & q.method) : e.methods != 0)
+        return false;
+
+    const std::span<const DomainId> host(q.hostIds.data(), q.hostCount),
+        initiator(q.initiatorIds.data(), q.initiatorCount);
+    if (e.requestDomains.size && !in_list(e.requestDomains, host)) return false;
+    if (e.excludedRequestDomains.size && in_list(e.excludedRequestDomains, host)) return false;
+    if (e.initiatorDomains.size && (!q.hasInitiator || !in_list(e.initiatorDomains, initiator)))
+        return false;
+    if (e.excludedInitiatorDomains.size && q.hasInitiator && in_list(e.excludedInitiatorDomains, initiator))
+        return false;
+
+    if (e.pattern >= 0 && !patterns_[e.pattern].matches(q.url, q.hostBegin, q.hostEnd)) return false;
+    if (e.regex != NO_REGEX) {
+        if (e.regex < 0) return false;
+        // Ein DFA-Durchlauf (samt Vorfilter) liefert alle regexFilter auf einmal
+        if (!q.regexDone) {
+            regexes_.search(q.url, q.regexHits);
+            q.regexDone = true;
+        }
+        if (!(q.regexHits[e.regex / 64] >> (e.regex % 64) & 1)) return false;
+    }
+    return true;
+}
+
+// Prüft rule nur, wenn sie best schlagen könnte (höherer Rang oder
+// gleicher Rang weiter vorn)
+void RuleMatcher::consider(uint32_t rule, Query &q, uint32_t &best) const {
+    ++q.cost.candidates;
+    if (best != NO_RULE) {
+        const uint64_t r = entries_[rule].rank, b = entries_[best].rank;
+        if (r < b || (r == b && rule >= best)) return;
+    }
+    ++q.cost.verified;
+    if (verify(rule, q)) best = rule;
+}
+
+const DnrRule *RuleMatcher::match(std::string_view url, std::string_view initiator, ResourceType type,
+                                  std::string_view method) const {
+    Query q;
+    prepare(q, url, initiator, type, method);
+    const uint32_t best = best_rule(q);
+    return best == NO_RULE ? nullptr : &rules_[best];
+}
+
+const DnrRule *RuleMatcher::match(std::string_view url, std::string_view initiator, ResourceType type,
+                                  std::string_view method, MatchCost &cost) const {
+    Query q;
+    prepare(q, url, initiator, type, method);
+    const uint32_t best = best_rule(q);
+    cost.candidates += q.cost.candidates;
+    cost.verified += q.cost.verified;
+    return best == NO_RULE ? nullptr : &rules_[best];
+}
+
+uint32_t RuleMatcher::best_rule(Query &q) const {
+    uint32_t best = NO_RULE;
+    for (size_t k = 0; k < q.hostCount; ++k) {
+        const DomainId h = q.hostIds[k];
+        for (uint32_t i = byHost_.start[h]; i < byHost_.start[h + 1]; ++i)
+            consider(byHost_.rules[i], q, best);
+    }
+    for (size_t k = 0; k < q.initiatorCount; ++k) {
+        const DomainId h = q.initiatorIds[k];
+        for (uint32_t i = byInitiator_.start[h]; i < byInitiator_.start[h + 1]; ++i)
+            consider(byInitiator_.rules[i], q, best);
+    }
+    for (const uint64_t token : q.tokens) {
+        const uint32_t t = token_id(token);
+        if (t == NO_RULE) continue;
+        for (uint32_t i = byToken_.start[t]; i < byToken_.start[t + 1]; ++i)
+            consider(byToken_.rules[i], q, best);
+    }
+    for (const uint32_t rule : generic_) consider(rule, q, best);
+    return best;
+}
+
+const DnrRule *RuleMatcher::match_linear(std::string_view url, std::string_view initiator, ResourceType type,
+                                         std::string_view method) const {
+    Query q;
+    prepare(q, url, initiator, type, method);
+    uint32_t best = NO_RULE;
+    for (uint32_t rule = 0; rule < entries_.size(); ++rule) consider(rule, q, best);
+    return best == NO_RULE ? nullptr : &rules_[best];
+}
@@ -0,0 +1,163 @@
+/***********************************************************************
+ *  Offline-Matcher für DnrRules (Chrome-DNR-Semantik)
+ *
+ *  Beantwortet für einen Request, welche Regel Chrome anwenden würde,
+ *  ohne die Regeln in den Browser zu laden – für Benchmarks von
+ *  Regelsätzen und Gegenproben der Optimierungs-Pässe
+ *  (tools/matchcheck.cc).  Nur nativ, nicht Teil des WASM-Builds.
+ *
+ *  Semantik wie chrome.declarativeNetRequest:
+ *    – urlFilter mit '*', '^', '|' und '||' (tools/urlfilter_ref.h),
+ *      regexFilter irgendwo in der URL; beides ohne Rücksicht auf
+ *      Groß-/Kleinschreibung
+ *    – request- und initiatorDomains samt Ausschlüssen: Host gleich
+ *      der Domain oder eine Subdomain davon; ohne Initiator greifen
+ *      initiatorDomains nie
+ *    – resourceTypes (ohne: alle außer main_frame), Methoden
+ *    – höchste Priorität gewinnt, bei Gleichstand allow vor block
+ *
+ *  Index: Regeln, die nur auf bestimmten Hosts greifen können
+ *  (requestDomains oder "||host/"-, "||host^"-Anker), hängen an ihren
+ *  Domains; eine Abfrage schlägt nur die Label-Suffixe des Hosts nach
+ *  (HostSuffixIndex, eine Sonde je Label).
+ *  Ebenso Regeln mit initiatorDomains über den Initiator.  Generische
+ *  urlFilter hängen an ihrem seltensten Token (Buchstaben-/Ziffernfolge,
+ *  die in jeder getroffenen URL vollständig vorkommen muss); die URL
+ *  wird dafür einmal zerlegt.  Nur was kein solches Token hat und
+ *  regexFilter werden je Abfrage durchlaufen; die regexFilter prüft
+ *  beim ersten Bedarf ein einziger Durchlauf über alle (RegexSet,
+ *  regex_dfa.h).  Deshalb ist auch match nicht threadsicher.
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "parser.h"
+#include "regex_dfa.h"
+
+// Trifft filter (urlFilter-Syntax) die URL?  Baustein für Gegenproben,
+// kompiliert das Muster bei jedem Aufruf.
+bool url_filter_matches(std::string_view filter, std::string_view url);
+
+// Label-Suffixe eines Hosts → IDs einer DomainTable.  Offene
+// Adressierung in einem flachen Array; der Schlüssel ist ein Hash, der
+// Label für Label von rechts wächst, so dass eine Abfrage den Host
+// einmal von hinten durchläuft und an jeder Label-Grenze genau eine
+// Sonde braucht, unabhängig von der Zahl der Domains.
+class HostSuffixIndex {
+public:
+    // Übernimmt alle Domains aus domains (die Tabelle wird danach nicht
+    // mehr gebraucht)
+    void build(const DomainTable &domains);
+
+    // IDs der bekannten Suffixe von host (Kleinbuchstaben), das kürzeste
+    // zuerst; betrachtet die max kürzesten Suffixe.  Liefert die Zahl.
+    size_t lookup(std::string_view host, DomainId *ids, size_t max) const;
+
+private:
+    // Je Slot die oberen Hash-Bits (über refMask_) und Position + 1 des
+    // Eintrags in entries_; 0 = leer
+    std::vector<uint32_t> slots_;
+    uint32_t              refMask_ = 0;
+    // Je Domain ID, Länge und Text (auf 4 Bytes aufgefüllt), damit ein
+    // Treffer mit einem Speicherzugriff bestätigt ist
+    std::vector<uint32_t> entries_;
+};
+
+// Aufwand einer Abfrage
+struct MatchCost {
+    size_t candidates = 0;      // aus Index und Restliste angesehene Regeln
+    size_t verified   = 0;      // davon voll geprüft (konnten den Rang noch schlagen)
+};
+
+struct MatcherStats {
+    size_t hostIndexed      = 0;    // über Request-Host-Suffixe gefunden
+    size_t initiatorIndexed = 0;    // über Initiator-Suffixe gefunden
+    size_t tokenIndexed     = 0;    // generische urlFilter, über ihr Schlüssel-Token gefunden
+    size_t generic          = 0;    // urlFilter ohne Host-Bezug und Token, je Abfrage geprüft
+    size_t regex            = 0;    // regexFilter ohne Host-Bezug, je Abfrage geprüft
+    size_t badRegex         = 0;    // regexFilter, die RegexSet nicht übersetzt (treffen nie)
+};
+
+class RuleMatcher {
+public:
+    // rules müssen leben, solange der Matcher benutzt wird; domains
+    // (die Tabelle der Regeln) braucht nur der Konstruktor
+    RuleMatcher(std::span<const DnrRule> rules, const DomainTable &domains);
+    ~RuleMatcher();
+    RuleMatcher(const RuleMatcher &)            = delete;
+    RuleMatcher &operator=(const RuleMatcher &) = delete;
+
+    // Regel, die Chrome auf den Request anwenden würde, oder nullptr.
+    // initiator ist Origin oder Host der auslösenden Seite (leer = ohne,
+    // etwa bei Navigationen aus der Adresszeile).  Bei gleichem Rang
+    // gewinnt die Regel, die in rules zuerst steht.
+    const DnrRule *match(std::string_view url, std::string_view initiator, ResourceType type,
+                         std::string_view method = "GET") const;
+
+    // Wie oben; addiert den Aufwand der Abfrage auf cost
+    const DnrRule *match(std::string_view url, std::string_view initiator, ResourceType type,
+                         std::string_view method, MatchCost &cost) const;
+
+    // Dasselbe ohne Index über alle Regeln (Referenz für Gegenproben)
+    const DnrRule *match_linear(std::string_view url, std::string_view initiator, ResourceType type,
+                                std::string_view method = "GET") const;
+
+    const MatcherStats    &stats() const { return stats_; }
+    RegexSetStats          regex_stats() const { return regexes_.stats(); }
+    const HostSuffixIndex &host_index() const { return suffixes_; }
+
+    struct UrlPattern;          // kompilierter urlFilter (matcher.cc)
+
+private:
+    struct Entry;
+    struct Query;
+
+    // Domain-Listen: Bereich sortierter Host-IDs in listPool_
+    struct ListRef {
+        uint32_t offset = 0, size = 0;
+    };
+
+    // Nach Host- bzw. Token-ID gruppierte Regel-Positionen (CSR: Regeln
+    // zu ID h liegen in rules[start[h], start[h + 1]))
+    struct Buckets {
+        std::vector<uint32_t> start;
+        std::vector<uint32_t> rules;
+    };
+
+    // Token-Hash → Token-ID; offene Adressierung, Schlüssel 0 = leer
+    struct TokenTable {
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> ids;
+    };
+
+    static void build_buckets(Buckets &b, size_t ids,
+                              const std::vector<std::pair<uint32_t, uint32_t>> &pairs);
+    void        build_token_index(const std::vector<uint32_t> &rules);
+    uint32_t    token_id(uint64_t hash) const;
+    void prepare(Query &q, std::string_view url, std::string_view initiator, ResourceType type,
+                 std::string_view method) const;
+    bool in_list(ListRef list, std::span<const DomainId> suffixes) const;
+    bool verify(uint32_t rule, Query &q) const;
+    void consider(uint32_t rule, Query &q, uint32_t &best) const;
+    uint32_t best_rule(Query &q) const;
+
+    std::span<const DnrRule>   rules_;
+    DomainTable                hosts_;      // Domains der Listen und Anker, eigene IDs
+    HostSuffixIndex            suffixes_;   // über hosts_
+    std::vector<Entry>         entries_;
+    std::vector<UrlPattern>    patterns_;
+    RegexSet                   regexes_;    // alle regexFilter, Nummer in Entry
+    std::vector<DomainId>      listPool_;
+    Buckets                    byHost_, byInitiator_;
+    TokenTable                 tokens_;
+    Buckets                    byToken_;
+    std::vector<uint32_t>      generic_;    // urlFilter ohne Token und regexFilter
+    MatcherStats               stats_;
+};
@@ -0,0 +1,1024 @@
+/***********************************************************************
+ *  Optimierungs-Pässe über die geparste Regelmenge (siehe optimize.h)
+ ***********************************************************************/
+
+#include "optimize.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "regex.h"
+#include "text_scan.h"
+
+/* ------------------------------------------------------------------ *
+ *  Hilfs-Utilities
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr char ascii_lower(char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; }
+
+// splitmix64-Finalizer
+constexpr uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+struct Hasher {
+    uint64_t h = 0xCBF29CE484222325ull;                // FNV-1a
+    void byte(char c) { h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3ull; }
+    void add(uint64_t v) { h = mix64(h ^ v); }
+};
+
+uint64_t hash_icase(std::string_view s) {
+    Hasher h;
+    for (const char c : s) h.byte(ascii_lower(c));
+    return mix64(h.h ^ s.size());
+}
+
+bool equal_icase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (ascii_lower(a[i]) != ascii_lower(b[i])) return false;
+    return true;
+}
+
+/* -- urlFilter ------------------------------------------------------ */
+
+// Führende/abschließende '*' sind ohne Anker redundant.  Ein '*' vor
+// bzw. nach '|' bleibt, sonst würde aus dem Literal ein Anker.
+std::string_view strip_wildcards(std::string_view f) {
+    while (f.size() > 1 && f[0] == '*' && f[1] != '|') f.remove_prefix(1);
+    while (f.size() > 1 && f.back() == '*' && f[f.size() - 2] != '|') f.remove_suffix(1);
+    return f;
+}
+
+uint64_t hash_url_filter(std::string_view f) {
+    f = strip_wildcards(f);
+    Hasher h;
+    char   prev = 0;
+    for (const char c : f) {
+        if (c == '*' && prev == '*') continue;
+        h.byte(ascii_lower(c));
+        prev = c;
+    }
+    return mix64(h.h);
+}
+
+bool url_filter_equal(std::string_view a, std::string_view b) {
+    a = strip_wildcards(a);
+    b = strip_wildcards(b);
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const char c = a[i];
+        if (ascii_lower(c) != ascii_lower(b[j])) return false;
+        ++i, ++j;
+        if (c == '*') {
+            while (i < a.size() && a[i] == '*') ++i;
+            while (j < b.size() && b[j] == '*') ++j;
+        }
+    }
+    return i == a.size() && j == b.size();
+}
+
+/* -- Domain-Listen als Mengen --------------------------------------- */
+
+// Reihenfolge-unabhängig: Summe der Element-Hashes
+uint64_t hash_domain_set(DomainList list) {
+    uint64_t sum = 0;
+    for (const auto d : list) sum += mix64(d + 1);
+    return mix64(sum ^ list.size());
+}
+
+bool contains(DomainList list, DomainId d) { return std::find(list.begin(), list.end(), d) != list.end(); }
+
+bool domain_set_equal(DomainList a, DomainList b) {
+    if (a.size() != b.size()) return false;
+    if (a.size() <= 16) {
+        for (const auto d : a)
+            if (!contains(b, d)) return false;
+        for (const auto d : b)
+            if (!contains(a, d)) return false;
+        return true;
+    }
+    auto canonical = [](DomainList l) {
+        std::vector<DomainId> v(l.begin(), l.end());
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+        return v;
+    };
+    return canonical(a) == canonical(b);
+}
+
+}  // namespace
+
+/* ------------------------------------------------------------------ *
+ *  Strukturelle Gleichheit
+ * ------------------------------------------------------------------ */
+
+uint64_t rule_hash(const DnrRule &r) {
+    Hasher h;
+    h.add(hash_icase(r.actionType));
+    h.add(static_cast<uint64_t>(r.priority));
+    h.add(r.conditionUrlFilter ? hash_url_filter(*r.conditionUrlFilter) : 1);
+    if (r.conditionRegexFilter)
+        for (const char c : *r.conditionRegexFilter) h.byte(c);
+    h.add(r.conditionRegexFilter ? 2 : 3);
+    h.add(uint64_t(r.conditionResourceTypes) | uint64_t(r.conditionRequestMethods) << 16 |
+          uint64_t(r.conditionExcludedRequestMethods) << 24);
+    h.add(hash_domain_set(r.conditionRequestDomains));
+    h.add(hash_domain_set(r.conditionExcludedRequestDomains));
+    h.add(hash_domain_set(r.conditionInitiatorDomains));
+    h.add(hash_domain_set(r.conditionExcludedInitiatorDomains));
+    return h.h;
+}
+
+bool same_rule(const DnrRule &a, const DnrRule &b) {
+    return a.actionType == b.actionType && a.priority == b.priority &&
+           a.conditionResourceTypes == b.conditionResourceTypes &&
+           a.conditionRequestMethods == b.conditionRequestMethods &&
+           a.conditionExcludedRequestMethods == b.conditionExcludedRequestMethods &&
+           a.conditionRegexFilter == b.conditionRegexFilter &&
+           a.conditionUrlFilter.has_value() == b.conditionUrlFilter.has_value() &&
+           (!a.conditionUrlFilter || url_filter_equal(*a.conditionUrlFilter, *b.conditionUrlFilter)) &&
+           domain_set_equal(a.conditionRequestDomains, b.conditionRequestDomains) &&
+           domain_set_equal(a.conditionExcludedRequestDomains, b.conditionExcludedRequestDomains) &&
+           domain_set_equal(a.conditionInitiatorDomains, b.conditionInitiatorDomains) &&
+           domain_set_equal(a.conditionExcludedInitiatorDomains, b.conditionExcludedInitiatorDomains);
+}
+
+/* ------------------------------------------------------------------ *
+ *  Duplikate entfernen
+ *
+ *  Offene Adressierung über die Hashes; bei Hash-Gleichheit
+ *  entscheidet same_rule.  Ein Slot hält die oberen 32 Hash-Bits und
+ *  die Position im bereits kompaktierten Vorderteil des Vektors (der
+ *  beim Weiterschreiben nicht mehr überschrieben wird), damit Sondieren
+ *  ohne Zugriff auf die Regeln auskommt.
+ * ------------------------------------------------------------------ */
+
+int remove_duplicate_rules(std::vector<DnrRule> &rules) {
+    const size_t n = rules.size();
+    if (n < 2) return 0;
+
+    struct Slot {
+        uint32_t tag;
+        uint32_t pos;
+    };
+    constexpr uint32_t EMPTY = UINT32_MAX;
+    size_t cap = 16;
+    while (cap < n * 2) cap <<= 1;
+    std::vector<Slot> table(cap, Slot{0, EMPTY});
+
+    // Hashes vorab, damit der Slot einige Regeln im Voraus geladen
+    // werden kann (die Tabelle passt bei großen Listen nicht in den Cache)
+    constexpr size_t      PREFETCH = 16;
+    std::vector<uint64_t> hashes(n);
+    for (size_t i = 0; i < n; ++i) hashes[i] = rule_hash(rules[i]);
+
+    size_t out = 0;
+    for (size_t i = 0; i < n; ++i) {
+#if defined(__GNUC__)
+        if (i + PREFETCH < n) __builtin_prefetch(&table[hashes[i + PREFETCH] & (cap - 1)]);
+#endif
+        const uint64_t h    = hashes[i];
+        const uint32_t tag  = static_cast<uint32_t>(h >> 32);
+        size_t         slot = h & (cap - 1);
+        bool           dup  = false;
+        for (; table[slot].pos != EMPTY; slot = (slot + 1) & (cap - 1)) {
+            if (table[slot].tag == tag && same_rule(rules[table[slot].pos], rules[i])) {
+                dup = true;
+                break;
+            }
+        }
+        if (dup) continue;
+        if (out != i) rules[out] = rules[i];
+        table[slot] = {tag, static_cast<uint32_t>(out)};
+        ++out;
+    }
+    rules.resize(out);
+    return static_cast<int>(n - out);
+}
+
+/* ------------------------------------------------------------------ *
+ *  Einfache Regexe als urlFilter
+ *
+ *  regexFilter und urlFilter werden beide case-insensitiv gegen die
+ *  kanonische URL geprüft, die regex als Suche irgendwo in der URL.
+ *  Besteht eine Regex nur aus Literalen, '.*', '^'/'$' am Rand und
+ *  kleinen Alternativen (auch "s?" und {n}), ist sie gleichbedeutend mit
+ *  einer Handvoll urlFilter-Regeln: '.*' wird '*', '^' und '$' werden
+ *  '|'-Anker, jede Alternative wird eine eigene Regel mit denselben
+ *  übrigen Konditionen.  urlFilter kennt kein Escaping – Literale '*',
+ *  '|' und '^' sowie Nicht-ASCII bleiben deshalb Regex.
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr size_t MAX_LOWERED_VARIANTS = 4;
+constexpr int    MAX_LOWERED_REPEAT   = 8;
+
+// Varianten als Strings: Literal-Bytes, '*' für beliebig viele
+// Zeichen, ANCHOR_BEGIN/ANCHOR_END für '^'/'$'
+constexpr char ANCHOR_BEGIN = '\x01';
+constexpr char ANCHOR_END   = '\x02';
+
+using Variants = std::vector<std::string>;
+
+bool url_filter_literal(unsigned char c) {
+    return c > 0x20 && c < 0x7F && c != '*' && c != '|' && c != '^';
+}
+
+bool lower_regex_node(const RegexAst &ast, uint32_t n, Variants &out) {
+    const RegexNode &node = ast[n];
+    switch (node.kind) {
+    case RegexKind::Empty:
+        out = {""};
+        return true;
+    case RegexKind::Literal:
+        if (!url_filter_literal(static_cast<unsigned char>(node.ch))) return false;
+        out = {std::string(1, node.ch)};
+        return true;
+    case RegexKind::Class: {
+        // Ein Zeichen bzw. beide Schreibweisen eines Buchstabens
+        if (node.unicode || node.set.count() == 0 || node.set.count() > 2) return false;
+        unsigned c = 0;
+        while (!node.set.test(c)) ++c;
+        if (node.set.count() == 2 && !(c >= 'A' && c <= 'Z' && node.set.test(c + 32))) return false;
+        if (!url_filter_literal(static_cast<unsigned char>(c))) return false;
+        if (node.set.count() == 2) c += 'a' - 'A';
+        out = {std::string(1, static_cast<char>(c))};
+        return true;
+    }
+    case RegexKind::BeginText:
+    case RegexKind::BeginLine:                      // URLs enthalten kein '\n'
+        out = {std::string(1, ANCHOR_BEGIN)};
+        return true;
+    case RegexKind::EndText:
+    case RegexKind::EndLine:
+        out = {std::string(1, ANCHOR_END)};
+        return true;
+    case RegexKind::Group:
+        return lower_regex_node(ast, node.kids[0], out);
+    case RegexKind::Alternate: {
+        out.clear();
+        Variants sub;
+        for (const uint32_t k : node.kids) {
+            if (!lower_regex_node(ast, k, sub)) return false;
+            out.insert(out.end(), sub.begin(), sub.end());
+            if (out.size() > MAX_LOWERED_VARIANTS) return false;
+        }
+        return true;
+    }
+    case RegexKind::Concat: {
+        out = {""};
+        Variants sub, next;
+        for (const uint32_t k : node.kids) {
+            if (!lower_regex_node(ast, k, sub)) return false;
+            if (out.size() * sub.size() > MAX_LOWERED_VARIANTS) return false;
+            next.clear();
+            for (const auto &a : out)
+                for (const auto &b : sub) next.push_back(a + b);
+            out.swap(next);
+        }
+        return true;
+    }
+    case RegexKind::Repeat: {
+        const RegexNode &kid = ast[node.kids[0]];
+        if (kid.kind == RegexKind::AnyChar) {
+            if (node.min != 0 || node.max >= 0) return false;      // nur '.*'
+            out = {"*"};
+            return true;
+        }
+        if (node.max < 0 || node.max > MAX_LOWERED_REPEAT) return false;
+        Variants body;
+        if (!lower_regex_node(ast, node.kids[0], body)) return false;
+        // x{min,max} = x^min gefolgt von max-min optionalen x
+        Variants optional = body;
+        optional.push_back("");
+        out = {""};
+        Variants next;
+        for (int i = 0; i < node.max; ++i) {
+            const Variants &part = i < node.min ? body : optional;
+            next.clear();
+            for (const auto &a : out)
+                for (const auto &b : part) next.push_back(a + b);
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            if (next.size() > MAX_LOWERED_VARIANTS) return false;
+            out.swap(next);
+        }
+        return true;
+    }
+    default:
+        return false;                               // '.', \b, Klassen, ...
+    }
+}
+
+// Variante → urlFilter; leer, wenn sie sich nicht ausdrücken lässt.
+// urlFilter sucht ohne '|' ohnehin irgendwo in der URL, '*' an einem
+// nicht verankerten Rand entfällt deshalb (ebenso ein Anker vor '*').
+std::string variant_to_url_filter(std::string_view v) {
+    bool begin = v.starts_with(ANCHOR_BEGIN);
+    bool end   = v.size() > size_t(begin) && v.ends_with(ANCHOR_END);
+    if (begin) v.remove_prefix(1);
+    if (end) v.remove_suffix(1);
+    if (v.find_first_of(std::string_view("\x01\x02", 2)) != std::string_view::npos) return {};
+    if (v.starts_with('*')) begin = false;
+    if (v.ends_with('*')) end = false;
+    while (v.starts_with('*')) v.remove_prefix(1);
+    while (v.ends_with('*')) v.remove_suffix(1);
+    if (v.empty()) return {};                       // träfe jede URL
+
+    std::string f = begin ? "|" : "";
+    for (const char c : v)
+        if (c != '*' || f.empty() || f.back() != '*') f.push_back(c);
+    if (end) f.push_back('|');
+    return f;
+}
+
+}  // namespace
+
+int lower_regex_rules(std::vector<DnrRule> &rules, RuleArena &arena) {
+    std::vector<DnrRule>     out;
+    Variants                 variants;
+    std::vector<std::string> filters;
+    int                      lowered = 0;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const DnrRule &r = rules[i];
+        filters.clear();
+        if (r.conditionRegexFilter && !r.conditionUrlFilter) {
+            const RegexAst ast = parse_regex(*r.conditionRegexFilter);
+            if (ast.error == RegexError::None && lower_regex_node(ast, ast.root, variants)) {
+                for (const auto &v : variants) {
+                    std::string f = variant_to_url_filter(v);
+                    if (f.empty()) {
+                        filters.clear();
+                        break;
+                    }
+                    if (std::find(filters.begin(), filters.end(), f) == filters.end())
+                        filters.push_back(std::move(f));
+                }
+            }
+        }
+        if (filters.empty()) {
+            if (lowered) out.push_back(r);
+            continue;
+        }
+        if (!lowered++) out.assign(rules.begin(), rules.begin() + static_cast<std::ptrdiff_t>(i));
+        for (const auto &f : filters) {
+            DnrRule copy = r;
+            copy.conditionRegexFilter.reset();
+            copy.conditionUrlFilter = canonical_url_filter(arena.copy(f), arena);
+            out.push_back(copy);
+        }
+    }
+    if (lowered) rules.swap(out);
+    return lowered;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Von Chrome abgelehnte Regexe
+ *
+ *  updateDynamicRules prüft jede Regel und verwirft bei einem Fehler
+ *  den ganzen Aufruf – eine Regex mit Lookahead kostet so 100 Regeln.
+ *  Läuft nach dem Lowering: was dort zu urlFilter wurde, ist sicher.
+ * ------------------------------------------------------------------ */
+
+int drop_unsupported_regex_rules(std::vector<DnrRule> &rules, std::vector<RejectedRegex> *report) {
+    const size_t before = rules.size();
+    std::erase_if(rules, [&](const DnrRule &r) {
+        if (!r.conditionRegexFilter) return false;
+        const RegexError e = check_regex_filter(*r.conditionRegexFilter);
+        if (e == RegexError::None) return false;
+        if (report) report->push_back({r.id, regex_error_name(e)});
+        return true;
+    });
+    return static_cast<int>(before - rules.size());
+}
+
+/* ------------------------------------------------------------------ *
+ *  Abdeckung über Domain-Anker
+ *
+ *  "||a.com^" trifft auch x.a.com, y.x.a.com, ...  Eine Regel mit
+ *  Domain-Anker ("||host" gefolgt von '/' oder '^') ist abgedeckt, wenn
+ *  eine nackte Regel ("||anc/" bzw. "||anc^") auf host oder einem
+ *  Vorfahren von host jeden Request trifft, den sie trifft.  Ob die
+ *  abgedeckte Regel dann entfallen darf, hängt an Aktion und Priorität
+ *  (Subsumption bzw. Shadowing unten).
+ *
+ *  Die Hosts hängen label-weise von rechts in einem Trie ("com" →
+ *  "a" → "x"); jeder Knoten merkt sich höchstens COVER_SLOTS nackte
+ *  Regeln.  Je Regel wird der eigene Pfad zur Wurzel abgelaufen – der
+ *  Aufwand ist linear in der Gesamtzahl der Labels.
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr RequestMethodMask ALL_REQUEST_METHODS_MASK = (1u << SUPPORTED_METHODS.size()) - 1;
+constexpr uint32_t          NO_COVER                 = UINT32_MAX;
+
+struct DomainAnchor {
+    std::string_view host;              // leer = kein Domain-Anker
+    char             sep  = 0;          // '/' oder '^' direkt nach dem Host
+    bool             bare = false;      // urlFilter endet mit sep
+};
+
+DomainAnchor domain_anchor(const DnrRule &r) {
+    if (!r.conditionUrlFilter || r.conditionRegexFilter || !r.conditionRequestDomains.empty())
+        return {};
+    const std::string_view f = *r.conditionUrlFilter;
+    if (!f.starts_with("||")) return {};
+    size_t end = 2;
+    while (end < f.size()) {
+        const char l = ascii_lower(f[end]);
+        if (!((l >= 'a' && l <= 'z') || (l >= '0' && l <= '9') || l == '-' || l == '.' || l == '_'))
+            break;
+        ++end;
+    }
+    if (end == 2 || end == f.size() || (f[end] != '/' && f[end] != '^')) return {};
+    const std::string_view host = f.substr(2, end - 2);
+    if (host.front() == '.' || host.back() == '.') return {};
+    return {host, f[end], end + 1 == f.size()};
+}
+
+// Ohne resourceTypes trifft Chrome alle Typen außer main_frame
+ResourceTypeMask effective_types(const DnrRule &r) {
+    return r.conditionResourceTypes
+               ? r.conditionResourceTypes
+               : ResourceTypeMask(ALL_RESOURCE_TYPES_MASK & ~resource_type_bit(ResourceType::MainFrame));
+}
+
+RequestMethodMask effective_methods(const DnrRule &r) {
+    const RequestMethodMask inc = r.conditionRequestMethods ? r.conditionRequestMethods
+                                                            : ALL_REQUEST_METHODS_MASK;
+    return inc & ~r.conditionExcludedRequestMethods;
+}
+
+// d ist p selbst oder eine Subdomain davon.  Gleicher Text heißt gleiche
+// ID, der Text in der Tabelle ist schon klein geschrieben.
+bool domain_within(DomainId d, DomainId p, const DomainTable &domains) {
+    if (d == p) return true;
+    const std::string_view ds = domains[d], ps = domains[p];
+    return ds.size() > ps.size() && ds[ds.size() - ps.size() - 1] == '.' && ds.ends_with(ps);
+}
+
+// Jede Domain aus inner liegt in einer aus outer.  Sehr lange Listen
+// gelten als nicht abgedeckt, damit die Pässe linear bleiben.
+bool domains_within(DomainList inner, DomainList outer, const DomainTable &domains) {
+    constexpr size_t MAX_PAIRS = 4096;
+    if (inner.empty()) return true;
+    if (inner.size() * outer.size() > MAX_PAIRS) return false;
+    return std::all_of(inner.begin(), inner.end(), [&](DomainId d) {
+        return std::any_of(outer.begin(), outer.end(),
+                           [&](DomainId p) { return domain_within(d, p, domains); });
+    });
+}
+
+// Trifft die nackte Regel p (Anker pa) jeden Request, den c (Anker ca)
+// trifft?  Die Hosts prüft der Trie, hier nur Trenner und Konditionen.
+bool conditions_cover(const DnrRule &p, const DomainAnchor &pa, const DnrRule &c, const DomainAnchor &ca,
+                      const DomainTable &domains) {
+    if (pa.sep == '/' && ca.sep != '/') return false;            // '^' trifft auch ":port"
+    if (effective_types(c) & ~effective_types(p)) return false;
+    if (effective_methods(c) & ~effective_methods(p)) return false;
+    if (!p.conditionInitiatorDomains.empty() &&
+        (c.conditionInitiatorDomains.empty() ||
+         !domains_within(c.conditionInitiatorDomains, p.conditionInitiatorDomains, domains)))
+        return false;
+    return domains_within(p.conditionExcludedInitiatorDomains, c.conditionExcludedInitiatorDomains,
+                          domains) &&
+           domains_within(p.conditionExcludedRequestDomains, c.conditionExcludedRequestDomains, domains);
+}
+
+bool unconditional(const DnrRule &r) {
+    return r.conditionResourceTypes == 0 && r.conditionRequestMethods == 0 &&
+           r.conditionExcludedRequestMethods == 0 && r.conditionInitiatorDomains.empty() &&
+           r.conditionExcludedInitiatorDomains.empty() && r.conditionExcludedRequestDomains.empty();
+}
+
+// Trie über umgekehrte Labels; Kinder liegen in einer gemeinsamen
+// Hash-Tabelle mit Schlüssel (Elternknoten, Label)
+class LabelTrie {
+public:
+    static constexpr uint32_t ROOT        = 0;
+    static constexpr size_t   COVER_SLOTS = 4;
+
+    struct Node {
+        uint32_t         parent;
+        std::string_view label;
+        uint32_t         cover[COVER_SLOTS];
+        uint8_t          covers = 0;
+    };
+
+    explicit LabelTrie(size_t expectedLabels) {
+        size_t cap = 16;
+        while (cap < expectedLabels * 2) cap <<= 1;
+        slots_.assign(cap, EMPTY);
+        nodes_.reserve(expectedLabels + 1);
+        nodes_.push_back({ROOT, {}, {}, 0});
+    }
+
+    // Knoten für host anlegen (bzw. finden)
+    uint32_t insert(std::string_view host) {
+        uint32_t node = ROOT;
+        size_t   end  = host.size();
+        while (true) {
+            const size_t dot = host.rfind('.', end - 1);
+            const size_t beg = dot == std::string_view::npos ? 0 : dot + 1;
+            node = child(node, host.substr(beg, end - beg));
+            if (beg == 0) return node;
+            end = dot;
+        }
+    }
+
+    Node       &operator[](uint32_t n) { return nodes_[n]; }
+    const Node &operator[](uint32_t n) const { return nodes_[n]; }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    uint32_t child(uint32_t parent, std::string_view label) {
+        if (nodes_.size() * 2 >= slots_.size()) grow();
+        const size_t mask = slots_.size() - 1;
+        size_t       slot = slot_hash(parent, label) & mask;
+        for (; slots_[slot] != EMPTY; slot = (slot + 1) & mask) {
+            const Node &n = nodes_[slots_[slot]];
+            if (n.parent == parent && equal_icase(n.label, label)) return slots_[slot];
+        }
+        slots_[slot] = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({parent, label, {}, 0});
+        return slots_[slot];
+    }
+
+    static uint64_t slot_hash(uint32_t parent, std::string_view label) {
+        return mix64(hash_icase(label) ^ (uint64_t(parent) << 32));
+    }
+
+    void grow() {
+        std::vector<uint32_t> bigger(slots_.size() * 2, EMPTY);
+        const size_t          mask = bigger.size() - 1;
+        for (uint32_t i = 1; i < nodes_.size(); ++i) {
+            size_t slot = slot_hash(nodes_[i].parent, nodes_[i].label) & mask;
+            while (bigger[slot] != EMPTY) slot = (slot + 1) & mask;
+            bigger[slot] = i;
+        }
+        slots_.swap(bigger);
+    }
+
+    std::vector<uint32_t> slots_;
+    std::vector<Node>     nodes_;
+};
+
+// Liefert je Regel die Position einer nackten Regel, die sie abdeckt
+// und nach `outranks(p, c)` ersetzt (sonst NO_COVER).  `coverer` wählt
+// die Regeln, die als Abdecker in den Trie kommen.
+template <typename Coverer, typename Outranks>
+std::vector<uint32_t> find_covering_rules(const std::vector<DnrRule> &rules, const DomainTable &domains,
+                                          Coverer coverer, Outranks outranks) {
+    const size_t              n = rules.size();
+    std::vector<uint32_t>     coveredBy(n, NO_COVER);
+    std::vector<DomainAnchor> anchors(n);
+    size_t                    labels = 0;
+    for (size_t i = 0; i < n; ++i) {
+        anchors[i] = domain_anchor(rules[i]);
+        if (anchors[i].host.empty()) continue;
+        labels += 1 + std::count(anchors[i].host.begin(), anchors[i].host.end(), '.');
+    }
+    if (labels == 0) return coveredBy;
+
+    // Aufbau: jede Regel bekommt ihren Host-Knoten, nackte Abdecker
+    // werden dort eingetragen.  Bei vollen Slots verdrängt eine
+    // bedingungslose Regel den letzten Eintrag – sie deckt am meisten ab.
+    LabelTrie             trie(labels);
+    std::vector<uint32_t> nodeOf(n, LabelTrie::ROOT);
+    for (size_t i = 0; i < n; ++i) {
+        if (anchors[i].host.empty()) continue;
+        nodeOf[i] = trie.insert(anchors[i].host);
+        if (!anchors[i].bare || !coverer(rules[i])) continue;
+        auto &node = trie[nodeOf[i]];
+        if (node.covers < LabelTrie::COVER_SLOTS)
+            node.cover[node.covers++] = static_cast<uint32_t>(i);
+        else if (unconditional(rules[i]))
+            node.cover[LabelTrie::COVER_SLOTS - 1] = static_cast<uint32_t>(i);
+    }
+
+    // Abfrage: Pfad vom eigenen Knoten zur Wurzel.  Auf dem eigenen
+    // Knoten können sich zwei Regeln gegenseitig abdecken (etwa "||a.com^"
+    // mit und ohne explizite Default-Typen); dann fällt nur die spätere.
+    auto covers = [&](uint32_t p, size_t c) {
+        return outranks(rules[p], rules[c]) &&
+               conditions_cover(rules[p], anchors[p], rules[c], anchors[c], domains);
+    };
+    for (size_t i = 0; i < n; ++i) {
+        if (anchors[i].host.empty()) continue;
+        for (uint32_t node = nodeOf[i]; node != LabelTrie::ROOT && coveredBy[i] == NO_COVER;
+             node = trie[node].parent) {
+            const auto &t = trie[node];
+            for (uint8_t k = 0; k < t.covers; ++k) {
+                const uint32_t p = t.cover[k];
+                if (p == i || !covers(p, i)) continue;
+                if (node == nodeOf[i] && p > i && anchors[i].bare && covers(static_cast<uint32_t>(i), p))
+                    continue;
+                coveredBy[i] = p;
+                break;
+            }
+        }
+    }
+    return coveredBy;
+}
+
+size_t erase_covered(std::vector<DnrRule> &rules, const std::vector<uint32_t> &coveredBy) {
+    size_t out = 0;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        if (coveredBy[i] != NO_COVER) continue;
+        if (out != i) rules[out] = rules[i];
+        ++out;
+    }
+    const size_t removed = rules.size() - out;
+    rules.resize(out);
+    return removed;
+}
+
+}  // namespace
+
+/* -- Subsumption ----------------------------------------------------- */
+
+// Gleiche Aktion und Priorität: für jeden Request bleibt die Menge der
+// (Aktion, Priorität)-Paare und damit Chromes Entscheidung gleich.
+int prune_subsumed_rules(std::vector<DnrRule> &rules, const DomainTable &domains) {
+    if (rules.size() < 2) return 0;
+    const auto coveredBy = find_covering_rules(
+        rules, domains, [](const DnrRule &) { return true; },
+        [](const DnrRule &p, const DnrRule &c) {
+            return p.actionType == c.actionType && p.priority == c.priority;
+        });
+    return static_cast<int>(erase_covered(rules, coveredBy));
+}
+
+/* -- Shadowing durch Ausnahmen --------------------------------------- */
+
+// Eine allow-Regel gewinnt gegen block bei gleicher oder höherer
+// Priorität; eine vollständig abgedeckte block-Regel entscheidet also nie.
+int prune_shadowed_rules(std::vector<DnrRule> &rules, const DomainTable &domains,
+                         std::vector<ShadowedRule> *report) {
+    if (rules.size() < 2) return 0;
+    const auto coveredBy = find_covering_rules(
+        rules, domains, [](const DnrRule &r) { return r.actionType == "allow"; },
+        [](const DnrRule &p, const DnrRule &c) {
+            return c.actionType == "block" && p.priority >= c.priority;
+        });
+    if (report)
+        for (size_t i = 0; i < rules.size(); ++i)
+            if (coveredBy[i] != NO_COVER) report->push_back({rules[i].id, rules[coveredBy[i]].id});
+    return static_cast<int>(erase_covered(rules, coveredBy));
+}
+
+/* ------------------------------------------------------------------ *
+ *  Nackte Domain-Regeln zusammenfassen
+ *
+ *  "||host^" trifft die Requests an host und seine Subdomains, ebenso
+ *  requestDomains:[host].  Regeln, die sich nur im Host unterscheiden,
+ *  werden deshalb zu einer Regel mit einer requestDomains-Liste.
+ *  "||host/" bleibt Einzelregel: es verlangt '/' direkt hinter dem
+ *  Host und trifft "http://host:8080/" nicht, requestDomains schon.
+ *  requestDomains verlangt ASCII in Kleinbuchstaben (IDN als Punycode);
+ *  andere Hosts bleiben ebenfalls Einzelregeln.
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr uint32_t NO_GROUP = UINT32_MAX;
+
+// Host aus "||host^", falls als requestDomains-Eintrag brauchbar
+std::string_view coalescable_host(const DnrRule &r) {
+    if (!r.conditionUrlFilter || r.conditionRegexFilter || !r.conditionRequestDomains.empty())
+        return {};
+    const std::string_view f = *r.conditionUrlFilter;
+    if (f.size() < 4 || !f.starts_with("||") || f.back() != '^') return {};
+    const std::string_view host = f.substr(2, f.size() - 3);
+    if (host.front() == '.' || host.front() == '-' || host.back() == '.') return {};
+    for (const char c : host) {
+        const char l = ascii_lower(c);
+        if (!((l >= 'a' && l <= 'z') || (l >= '0' && l <= '9') || l == '-' || l == '.' || l == '_'))
+            return {};
+    }
+    return host;
+}
+
+// Menge von (Gruppe, Host-ID)-Paaren mit offener Adressierung, ohne
+// Allokation pro Eintrag; ein Slot hält das Paar selbst
+class GroupHostSet {
+public:
+    explicit GroupHostSet(size_t expected) {
+        size_t cap = 16;
+        while (cap < expected * 2) cap <<= 1;
+        slots_.assign(cap, EMPTY);
+    }
+
+    bool insert(uint32_t group, DomainId host) {
+        const uint64_t key  = uint64_t(group) << 32 | host;
+        const size_t   mask = slots_.size() - 1;
+        size_t         slot = mix64(key) & mask;
+        for (; slots_[slot] != EMPTY; slot = (slot + 1) & mask)
+            if (slots_[slot] == key) return false;
+        slots_[slot] = key;
+        return true;
+    }
+
+private:
+    static constexpr uint64_t EMPTY = UINT64_MAX;               // Gruppe NO_GROUP kommt nie vor
+    std::vector<uint64_t>     slots_;
+};
+
+}  // namespace
+
+int coalesce_domain_rules(std::vector<DnrRule> &rules, RuleArena &arena, size_t maxDomains) {
+    if (maxDomains == 0 || rules.size() < 2) return 0;
+
+    struct Group {
+        DnrRule                       key;          // Regel ohne urlFilter
+        uint32_t                      first;        // Position des ersten Mitglieds
+        uint32_t                      members = 0;
+        std::vector<DomainId>         hosts;
+    };
+    std::vector<Group>    groups;
+    std::vector<uint32_t> groupOf(rules.size(), NO_GROUP);
+
+    // Schlüssel-Hash → Gruppen, die noch Platz haben (bei Hash-Kollision
+    // verschiedener Schlüssel mehrere)
+    std::unordered_map<uint64_t, std::vector<uint32_t>> open;
+    GroupHostSet                                        seen(rules.size());
+
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const std::string_view host = coalescable_host(rules[i]);
+        if (host.empty()) continue;
+
+        DnrRule key = rules[i];
+        key.conditionUrlFilter.reset();
+        key.id = 0;
+        auto &candidates = open[rule_hash(key)];
+
+        uint32_t g = NO_GROUP;
+        for (auto &c : candidates) {
+            if (!same_rule(groups[c].key, key)) continue;
+            if (groups[c].hosts.size() >= maxDomains) {         // voll → neue Gruppe
+                c = static_cast<uint32_t>(groups.size());
+                groups.push_back({key, static_cast<uint32_t>(i), 0, {}});
+            }
+            g = c;
+            break;
+        }
+        if (g == NO_GROUP) {
+            g = static_cast<uint32_t>(groups.size());
+            groups.push_back({key, static_cast<uint32_t>(i), 0, {}});
+            candidates.push_back(g);
+        }
+
+        const DomainId id = arena.domains().intern(host);
+        if (seen.insert(g, id)) groups[g].hosts.push_back(id);
+        ++groups[g].members;
+        groupOf[i] = g;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const uint32_t g = groupOf[i];
+        if (g == NO_GROUP || groups[g].members < 2) {
+            if (out != i) rules[out] = rules[i];
+            ++out;
+            continue;
+        }
+        if (groups[g].first != i) continue;
+
+        const auto &hosts = groups[g].hosts;
+        DomainId   *list  = arena.allocate<DomainId>(hosts.size());
+        std::copy(hosts.begin(), hosts.end(), list);
+        const int line = rules[i].id;                           // Zeile des ersten Mitglieds
+        rules[out] = groups[g].key;
+        rules[out].id = line;
+        rules[out].conditionRequestDomains = {list, hosts.size()};
+        ++out;
+    }
+    const int saved = static_cast<int>(rules.size() - out);
+    rules.resize(out);
+    return saved;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Regel-Budget
+ *
+ *  Statt das Ende der Liste abzuschneiden, wird nach erwartetem Nutzen
+ *  ausgewählt.  Der Wert einer Regel ist die Summe der Profilgewichte
+ *  aller Domains, die sie trifft (Profil-Domain gleich oder Subdomain
+ *  einer Regel-Domain); ohne Profil zählt jede Regel-Domain 1, Regeln
+ *  ohne Domain-Bezug zählen genericWeight.  Bei gleichen Kosten je
+ *  Regel maximiert die Auswahl nach absteigendem Wert die Summe –
+ *  Überlappungen haben Subsumption und Zusammenfassen vorher weitgehend
+ *  abgeräumt.
+ *
+ *  allow-Regeln haben keinen eigenen Wert.  Sie kommen vor ihrer
+ *  block-Regel ins Budget, sobald sich die Domains der beiden
+ *  überschneiden (oder eine keinen Domain-Bezug hat): Ohne ihre
+ *  Ausnahmen würde eine block-Regel mehr blockieren als die Liste.
+ *  Passt das Paket nicht mehr, entfällt die block-Regel; allow-Regeln
+ *  ohne verbliebenes Gegenstück entfallen ebenfalls.
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+// Ruft fn für jede Domain auf, auf die r beschränkt ist (requestDomains
+// oder Domain-Anker); false = kein Domain-Bezug
+template <typename Fn>
+bool for_each_rule_domain(const DnrRule &r, const DomainTable &domains, Fn &&fn) {
+    if (!r.conditionRequestDomains.empty()) {
+        for (const auto d : r.conditionRequestDomains) fn(domains[d]);
+        return true;
+    }
+    const std::string_view host = domain_anchor(r).host;
+    if (host.empty()) return false;
+    fn(host);
+    return true;
+}
+
+// "a.b.c" → "a.b.c", "b.c", "c"
+template <typename Fn>
+void for_each_suffix(std::string_view d, Fn &&fn) {
+    for (;;) {
+        fn(d);
+        const size_t dot = d.find('.');
+        if (dot == std::string_view::npos) return;
+        d.remove_prefix(dot + 1);
+    }
+}
+
+// Heterogener Lookup mit string_view in Maps mit std::string-Schlüssel
+struct StringViewHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+template <typename V>
+using StringMap = std::unordered_map<std::string, V, StringViewHash, std::equal_to<>>;
+
+std::string lower_copy(std::string_view s) {
+    std::string out(s);
+    std::transform(out.begin(), out.end(), out.begin(), ascii_lower);
+    return out;
+}
+
+}  // namespace
+
+bool parse_domain_weights(std::string_view text, DomainWeights &out) {
+    bool ok = true;
+    split_sv<'\n'>(text, [&](std::string_view line) {
+        if (const size_t hash = line.find('#'); hash != std::string_view::npos) line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty() || !ok) return;
+        const size_t gap = line.find_first_of(WHITESPACE);
+        if (gap == std::string_view::npos) {
+            ok = false;
+            return;
+        }
+        const std::string_view domain = line.substr(0, gap);
+        const std::string      value(trim(line.substr(gap)));
+        char                  *end = nullptr;
+        const double           w   = std::strtod(value.c_str(), &end);
+        if (end != value.c_str() + value.size() || !(w >= 0)) {
+            ok = false;
+            return;
+        }
+        if (domain == "*") out.genericWeight = w;
+        else               out.domains.emplace_back(lower_copy(domain), w);
+    });
+    return ok;
+}
+
+int select_rules_within_budget(std::vector<DnrRule> &rules, const DomainTable &domains,
+                               size_t maxRules, const DomainWeights *weights, BudgetReport &report) {
+    const size_t n = rules.size();
+    if (maxRules == 0 || n <= maxRules) return 0;
+
+    // Profil-Gewichte auf alle Vorfahren aufsummiert: subtree["b.c"]
+    // enthält die Gewichte von b.c, a.b.c, x.a.b.c, ...
+    StringMap<double> subtree;
+    if (weights)
+        for (const auto &[domain, w] : weights->domains)
+            for_each_suffix(domain, [&](std::string_view s) { subtree[std::string(s)] += w; });
+    const double genericWeight = weights ? weights->genericWeight : 1.0;
+
+    std::string key;
+    auto domain_weight = [&](std::string_view d) {
+        if (!weights) return 1.0;
+        key.assign(d);
+        std::transform(key.begin(), key.end(), key.begin(), ascii_lower);
+        const auto it = subtree.find(key);
+        return it == subtree.end() ? 0.0 : it->second;
+    };
+
+    // allow-Regeln nach Domain: genau dort bzw. unterhalb eines Vorfahren
+    std::vector<uint32_t>            genericAllows, blocks;
+    StringMap<std::vector<uint32_t>> allowAt, allowBelow;
+    std::vector<double>              value(n, 0.0);
+    size_t                           allowCount = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const auto idx = static_cast<uint32_t>(i);
+        if (rules[i].actionType != "allow") {
+            double v = 0;
+            if (!for_each_rule_domain(rules[i], domains, [&](std::string_view d) { v += domain_weight(d); }))
+                v = genericWeight;
+            value[i] = v;
+            blocks.push_back(idx);
+            continue;
+        }
+        ++allowCount;
+        const bool scoped = for_each_rule_domain(rules[i], domains, [&](std::string_view d) {
+            const std::string lower = lower_copy(d);
+            allowAt[lower].push_back(idx);
+            for_each_suffix(lower, [&](std::string_view s) {
+                if (s.size() < lower.size()) allowBelow[std::string(s)].push_back(idx);
+            });
+        });
+        if (!scoped) genericAllows.push_back(idx);
+    }
+    std::stable_sort(blocks.begin(), blocks.end(),
+                     [&](uint32_t a, uint32_t b) { return value[a] > value[b]; });
+
+    // Ausnahmen ohne Domain-Bezug gehören zu jeder block-Regel und
+    // werden als Gruppe gezählt, nicht je Kandidat aufgezählt
+    std::vector<uint8_t>  keep(n, 0);
+    std::vector<uint32_t> need;
+    size_t                remaining = maxRules, unkeptAllows = allowCount;
+    bool                  genericKept = genericAllows.empty();
+    auto add_need = [&](const std::vector<uint32_t> &list) {
+        for (const uint32_t a : list)
+            if (!keep[a]) keep[a] = 2, need.push_back(a);         // 2 = vorgemerkt
+    };
+    for (const uint32_t b : blocks) {
+        if (remaining == 0) break;
+        need.clear();
+        const bool scoped = for_each_rule_domain(rules[b], domains, [&](std::string_view d) {
+            if (unkeptAllows == 0) return;
+            key.assign(d);
+            std::transform(key.begin(), key.end(), key.begin(), ascii_lower);
+            if (const auto it = allowBelow.find(key); it != allowBelow.end()) add_need(it->second);
+            for_each_suffix(key, [&](std::string_view s) {
+                if (const auto it = allowAt.find(s); it != allowAt.end()) add_need(it->second);
+            });
+        });
+        // Ohne Domain-Bezug überschneidet sich die Regel mit jeder Ausnahme
+        const size_t extra = !scoped ? unkeptAllows
+                                     : need.size() + (genericKept ? 0 : genericAllows.size());
+        if (1 + extra > remaining) {
+            for (const uint32_t a : need) keep[a] = 0;
+            continue;
+        }
+        if (!scoped && unkeptAllows > 0) {
+            for (size_t i = 0; i < n; ++i)
+                if (rules[i].actionType == "allow") keep[i] = 1;
+        }
+        if (scoped && !genericKept)
+            for (const uint32_t a : genericAllows) keep[a] = 1;
+        for (const uint32_t a : need) keep[a] = 1;
+        keep[b]     = 1;
+        genericKept = true;
+        remaining    -= 1 + extra;
+        unkeptAllows -= extra;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < n; ++i) {
+        report.totalWeight += value[i];
+        if (!keep[i]) {
+            report.droppedWeight += value[i];
+            report.dropped.push_back({rules[i].id, rules[i].actionType == "allow", value[i]});
+            continue;
+        }
+        if (out != i) rules[out] = rules[i];
+        ++out;
+    }
+    rules.resize(out);
+    return static_cast<int>(n - out);
+}
+
+/* ------------------------------------------------------------------ *
+ *  Pipeline
+ * ------------------------------------------------------------------ */
+
+void optimize_rules(std::vector<DnrRule> &rules, RuleArena &arena,
+                    const OptimizeOptions &options, OptimizeStats &stats) {
+    stats.parsedRules        += static_cast<int>(rules.size());
+    stats.loweredRegexRules  += lower_regex_rules(rules, arena);
+    stats.rejectedRegexRules += drop_unsupported_regex_rules(rules, &stats.rejected);
+    stats.duplicateRules     += remove_duplicate_rules(rules);
+    stats.shadowedRules      += prune_shadowed_rules(rules, arena.domains(),
+                                                     options.reportShadowed ? &stats.shadowed : nullptr);
+    stats.subsumedRules      += prune_subsumed_rules(rules, arena.domains());
+    stats.coalescedRules     += coalesce_domain_rules(rules, arena, options.maxRequestDomains);
+    stats.droppedRules       += select_rules_within_budget(rules, arena.domains(), options.maxRules,
+                                                           options.weights, stats.budget);
+}
@@ -0,0 +1,144 @@
+/***********************************************************************
+ *  Optimierungs-Pässe über die geparste Regelmenge
+ *
+ *  Laufen nach dem Parsen und vor der ID-Vergabe über alle Regeln
+ *  einer Liste – auch im parallelen Pfad sequentiell, damit die
+ *  Ausgabe byte-identisch bleibt.  Jeder Pass meldet in
+ *  OptimizeStats, was er verändert hat.
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "parser.h"
+
+// Von einer Ausnahme verdeckte block-Regel, jeweils als Zeilennummer
+// in der Liste
+struct ShadowedRule {
+    int line;
+    int allowLine;
+};
+
+// Von Chrome abgelehnte regexFilter-Regel (Zeilennummer in der Liste)
+// und der Grund (regex_error_name)
+struct RejectedRegex {
+    int              line;
+    std::string_view reason;
+};
+
+// Wegen des Budgets entfernte Regel (Zeilennummer in der Liste bzw.
+// des ersten Mitglieds einer zusammengefassten Regel)
+struct DroppedRule {
+    int    line;
+    bool   allow;
+    double weight;
+};
+
+struct BudgetReport {
+    double                   totalWeight   = 0;     // Summe der Regel-Werte vor der Auswahl
+    double                   droppedWeight = 0;     // davon entfallen
+    std::vector<DroppedRule> dropped;
+};
+
+struct OptimizeStats {
+    int parsedRules        = 0;  // Regeln vor allen Pässen
+    int loweredRegexRules  = 0;  // regexFilter-Regeln durch urlFilter ersetzt
+    int rejectedRegexRules = 0;  // regexFilter, die Chrome ablehnen würde
+    int duplicateRules     = 0;  // strukturell gleiche Regeln entfernt
+    int shadowedRules      = 0;  // block-Regeln, die eine allow-Regel verdeckt
+    int subsumedRules      = 0;  // von einer Regel auf einer Eltern-Domain abgedeckt
+    int coalescedRules     = 0;  // in requestDomains-Regeln aufgegangen (netto)
+    int droppedRules       = 0;  // wegen OptimizeOptions::maxRules entfallen
+
+    std::vector<ShadowedRule>  shadowed;    // nur mit OptimizeOptions::reportShadowed
+    std::vector<RejectedRegex> rejected;    // immer, für den "regexReport"
+    BudgetReport               budget;      // nur mit OptimizeOptions::maxRules
+};
+
+// Trefferprofil: Gewicht je Domain (etwa Aufrufe aus einem Log).  Ein
+// Gewicht zählt für jede Regel, die die Domain trifft, also auch für
+// Regeln auf einer Eltern-Domain.
+struct DomainWeights {
+    std::vector<std::pair<std::string, double>> domains;        // Domain in Kleinbuchstaben
+    double                                      genericWeight = 1.0;    // Regeln ohne Domain-Bezug
+};
+
+// Textformat: je Zeile "domain gewicht", '#' leitet einen Kommentar
+// ein, "*" setzt genericWeight.  false bei einer ungültigen Zeile.
+bool parse_domain_weights(std::string_view text, DomainWeights &out);
+
+/* ------------------------------------------------------------------ *
+ *  Strukturelle Gleichheit
+ *
+ *  Zwei Regeln sind gleich, wenn sie dieselben Requests gleich
+ *  behandeln, unabhängig von der Schreibweise in der Liste:
+ *  Domain-Listen als Mengen von IDs (die DomainTable faltet schon
+ *  Groß-/Kleinschreibung; beide Regeln aus derselben Tabelle), urlFilter
+ *  case-insensitiv (Chrome-Default) ohne redundante '*' am Rand und
+ *  mit zusammengefassten '*'-Folgen, Masken und Aktion exakt,
+ *  regexFilter exakt.
+ * ------------------------------------------------------------------ */
+
+uint64_t rule_hash(const DnrRule &r);
+bool     same_rule(const DnrRule &a, const DnrRule &b);
+
+/* ------------------------------------------------------------------ *
+ *  Pässe
+ * ------------------------------------------------------------------ */
+
+// Ersetzt regexFilter-Regeln, deren Regex sich exakt als urlFilter
+// ausdrücken lässt (Literale, '.*', Anker, kleine Alternativen), durch
+// je eine urlFilter-Regel pro Alternative an derselben Stelle.  Liefert
+// die Zahl ersetzter Regex-Regeln.
+int lower_regex_rules(std::vector<DnrRule> &rules, RuleArena &arena);
+
+// Entfernt regexFilter-Regeln, die Chrome beim Hinzufügen ablehnen
+// würde (check_regex_filter in regex.h), und damit den ganzen
+// updateDynamicRules-Aufruf.  Ist report gesetzt, landen Zeile und
+// Grund dort.  Liefert die Zahl entfernter Regeln.
+int drop_unsupported_regex_rules(std::vector<DnrRule> &rules, std::vector<RejectedRegex> *report);
+
+// Entfernt spätere Kopien strukturell gleicher Regeln (die erste
+// bleibt an ihrer Position); liefert die Zahl entfernter Regeln
+int remove_duplicate_rules(std::vector<DnrRule> &rules);
+
+// Entfernt block-Regeln mit Domain-Anker, die eine nackte allow-Regel
+// auf host oder einer Eltern-Domain mit gleicher oder höherer Priorität
+// vollständig abdeckt (Typen, Methoden, Initiatoren).  domains ist die
+// Tabelle der Regeln.  Die Regeln tragen hier noch ihre Zeilennummer als
+// ID; ist report gesetzt, landen die Paare (block-Zeile, allow-Zeile)
+// dort.  Liefert die Zahl entfernter Regeln.
+int prune_shadowed_rules(std::vector<DnrRule> &rules, const DomainTable &domains,
+                         std::vector<ShadowedRule> *report);
+
+// Entfernt Regeln mit Domain-Anker ("||host/...", "||host^..."), die
+// eine nackte Regel auf host oder einer Eltern-Domain mit derselben
+// Aktion und Priorität und gleichen oder schwächeren Konditionen
+// vollständig abdeckt; liefert die Zahl entfernter Regeln
+int prune_subsumed_rules(std::vector<DnrRule> &rules, const DomainTable &domains);
+
+// Fasst nackte Domain-Regeln ("||host^" ohne weitere URL-Bedingung)
+// mit ansonsten gleichen Konditionen zu Regeln mit requestDomains
+// zusammen, höchstens maxDomains je Regel ("||host/" nicht: Ports).  Die neue
+// Regel steht an der Position ihres ersten Mitglieds; Gruppen mit nur
+// einer Regel bleiben unverändert.  Listen und Hosts landen in arena
+// und deren DomainTable, die auch die übrigen Regeln benutzen müssen.
+// Liefert die Zahl eingesparter Regeln.
+int coalesce_domain_rules(std::vector<DnrRule> &rules, RuleArena &arena, size_t maxDomains);
+
+// Wählt höchstens maxRules Regeln nach erwartetem Nutzen (siehe
+// optimize.cc); weights darf null sein (jede Domain zählt 1).  Die
+// Reihenfolge der verbleibenden Regeln bleibt erhalten.  Liefert die Zahl
+// entfernter Regeln, Details in report.
+int select_rules_within_budget(std::vector<DnrRule> &rules, const DomainTable &domains,
+                               size_t maxRules, const DomainWeights *weights, BudgetReport &report);
+
+// Alle Pässe in fester Reihenfolge.  Neu erzeugte Strings und Listen
+// landen in `arena`; deren DomainTable ist die der Regeln.
+void optimize_rules(std::vector<DnrRule> &rules, RuleArena &arena,
+                    const OptimizeOptions &options, OptimizeStats &stats);
@@ -11,113 +11,255 @@
  ***********************************************************************/
 
  #include <algorithm>
+ #include <array>
+ #include <atomic>
  #include <cctype>
+ #include <charconv>
+ #include <cstdint>
+ #include <functional>
+ #include <memory_resource>
  #include <optional>
- #include <sstream>
  #include <string>
  #include <string_view>
- #include <unordered_map>
+ #include <thread>
  #include <unordered_set>
  #include <vector>
  
  #include "nlohmann/json.hpp"
+ #include "optimize.h"
+ #include "parser.h"
+ #include "text_scan.h"
+ 
+ #ifdef __EMSCRIPTEN__
  #include <emscripten/bind.h>
+ #endif
  
  using json = nlohmann::json;
  
  /* ------------------------------------------------------------------ *
-  *  Hilfs-Utilities
+  *  Hilfs-Utilities (trim/split_sv: text_scan.h)
   * ------------------------------------------------------------------ */
  
- constexpr std::string_view WHITESPACE = " \t\r\n";
+ constexpr char ascii_lower(char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; }
  
- inline std::string_view trim(std::string_view sv) {
-     const auto begin = sv.find_first_not_of(WHITESPACE);
-     if (begin == std::string_view::npos) return {};
-     const auto end = sv.find_last_not_of(WHITESPACE);
-     return sv.substr(begin, end - begin + 1);
+ // Getrimmt, als Domain-IDs und ohne Duplikate (Reihenfolge bleibt) in
+ // die Arena übernehmen.  Kurze Listen per linearer Suche, lange über ein
+ // Set in der Arena.
+ inline DomainList unique_list(std::span<const std::string_view> views, RuleArena &arena) {
+     DomainTable &domains = arena.domains();
+     DomainId    *out     = arena.allocate<DomainId>(views.size());
+     size_t       n       = 0;
+     if (views.size() <= 16) {
+         for (auto v : views) {
+             v = trim(v);
+             if (v.empty()) continue;
+             const DomainId id = domains.intern(v);
+             if (std::find(out, out + n, id) == out + n) out[n++] = id;
+         }
+     } else {
+         std::pmr::unordered_set<DomainId> seen(views.size(), arena.resource());
+         for (auto v : views) {
+             v = trim(v);
+             if (v.empty()) continue;
+             const DomainId id = domains.intern(v);
+             if (seen.insert(id).second) out[n++] = id;
+         }
+     }
+     return {out, n};
  }
  
- template <char Delim, typename Callback>
- inline void split_sv(std::string_view sv, Callback &&cb) {
-     size_t start = 0;
-     for (size_t i = 0; i < sv.size(); ++i) {
-         if (sv[i] == Delim) {
-             cb(sv.substr(start, i - start));
-             start = i + 1;
-         }
+ /* ------------------------------------------------------------------ *
+  *  Domain-Tabelle
+  *
+  *  Offene Adressierung über FNV-1a der Kleinbuchstaben.  Ein Slot hält
+  *  die oberen 32 Hash-Bits (zugleich die Startposition) und ID + 1;
+  *  beim Wachsen wird deshalb kein Text neu gehasht.
+  * ------------------------------------------------------------------ */
+ 
+ static uint32_t domain_hash(std::string_view d) {
+     uint64_t h = 0xCBF29CE484222325ull;
+     for (const char c : d) h = (h ^ static_cast<unsigned char>(ascii_lower(c))) * 0x100000001B3ull;
+     h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;        // splitmix64-Finalizer
+     h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+     return static_cast<uint32_t>((h ^ (h >> 31)) >> 32);
+ }
+ 
+ DomainId DomainTable::intern(std::string_view domain) {
+     if (size() * 2 >= slots_.size()) grow();
+     const uint32_t h    = domain_hash(domain);
+     const size_t   mask = slots_.size() - 1;
+     size_t         slot = h & mask;
+     for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+         if (static_cast<uint32_t>(slots_[slot] >> 32) != h) continue;
+         const auto             id = static_cast<DomainId>(slots_[slot] - 1);
+         const std::string_view d  = (*this)[id];
+         if (d.size() == domain.size() &&
+             std::equal(d.begin(), d.end(), domain.begin(),
+                        [](char a, char b) { return a == ascii_lower(b); }))
+             return id;
      }
-     if (start < sv.size()) cb(sv.substr(start));
+     const auto id = static_cast<DomainId>(size());
+     for (const char c : domain) pool_.push_back(ascii_lower(c));
+     offsets_.push_back(static_cast<uint32_t>(pool_.size()));
+     slots_[slot] = uint64_t(h) << 32 | (uint64_t(id) + 1);
+     return id;
  }
  
- inline std::vector<std::string>
- to_string_vector_unique(const std::vector<std::string_view> &views) {
-     std::vector<std::string> out;
-     std::unordered_set<std::string_view> seen;
-     out.reserve(views.size());
-     for (auto v : views) {
-         v = trim(v);
-         if (!v.empty() && !seen.count(v)) {
-             out.emplace_back(v);
-             seen.insert(v);
-         }
+ void DomainTable::grow() {
+     std::vector<uint64_t> bigger(std::max<size_t>(64, slots_.size() * 2), 0);
+     const size_t          mask = bigger.size() - 1;
+     for (const uint64_t e : slots_) {
+         if (e == 0) continue;
+         size_t slot = (e >> 32) & mask;
+         while (bigger[slot] != 0) slot = (slot + 1) & mask;
+         bigger[slot] = e;
      }
-     return out;
+     slots_.swap(bigger);
+ }
+ 
+ void DomainTable::clear() {
+     pool_.clear();
+     offsets_.assign(1, 0);
+     slots_.clear();
  }
  
  /* ------------------------------------------------------------------ *
   *  Konstanten
   * ------------------------------------------------------------------ */
  
- const std::vector<std::string> ALL_DNR_RESOURCE_TYPES = {
-     "main_frame",  "sub_frame", "stylesheet",   "script",  "image",
-     "font",        "object",    "xmlhttprequest","ping",    "csp_report",
-     "media",       "websocket", "webtransport", "webbundle","other"};
- 
- const std::unordered_map<std::string_view, std::string> RESOURCE_TYPE_MAP = {
-     {"script", "script"},
-     {"image", "image"},           {"img", "image"},
-     {"stylesheet", "stylesheet"},
-     {"xmlhttprequest", "xmlhttprequest"}, {"xhr", "xmlhttprequest"},
-     {"subdocument", "sub_frame"}, {"sub_frame", "sub_frame"},
-     {"document", "main_frame"},   {"main_frame", "main_frame"},
-     {"websocket", "websocket"},   {"media", "media"},
-     {"font", "font"},             {"ping", "ping"},
-     {"other", "other"}};
- 
- const std::unordered_set<std::string> SUPPORTED_METHODS = {
-     "connect", "delete", "get", "head",
-     "options", "patch",  "post", "put"};
+ // Alle Tabellen sind constexpr: keine statische Initialisierung beim
+ // Laden des Moduls.  Ressourcentypen und Methoden: siehe parser.h.
  
  /* ------------------------------------------------------------------ *
-  *  Datenstrukturen
+  *  Options-Schlüsselwörter (perfekter Hash)
+  *
+  *  Jedes bekannte Schlüsselwort wird über einen zur Compile-Zeit
+  *  kollisionsfrei gewählten Hash auf genau einen Tabellenplatz
+  *  abgebildet; ein Lookup ist ein Hash plus ein Stringvergleich.
   * ------------------------------------------------------------------ */
  
- struct DnrRule {
-     int id;
-     int priority                 = 1;
-     std::string actionType       = "block";
- 
-     std::optional<std::string> conditionUrlFilter;
-     std::optional<std::string> conditionRegexFilter;
- 
-     std::optional<std::vector<std::string>> conditionResourceTypes;
-     std::optional<std::vector<std::string>> conditionRequestDomains;
-     std::optional<std::vector<std::string>> conditionExcludedRequestDomains;
-     std::optional<std::vector<std::string>> conditionInitiatorDomains;
-     std::optional<std::vector<std::string>> conditionExcludedInitiatorDomains;
-     std::optional<std::vector<std::string>> conditionRequestMethods;
-     std::optional<std::vector<std::string>> conditionExcludedRequestMethods;
+ enum class OptionKey : uint8_t {
+     Unknown,        // unbekannt → ignoriert
+     ResourceType,
+     Domain,         // domain=   → Initiator-Domains
+     Domains,        // domains=  → Request-Domains
+     Method,         // method= / request-method=
+     Ignored         // bekannt, aber ohne DNR-Entsprechung
+ };
+ 
+ struct OptionKeyword {
+     std::string_view name;
+     OptionKey        key  = OptionKey::Unknown;
+     ResourceType     type = ResourceType::Other;
  };
  
+ constexpr OptionKeyword OPTION_KEYWORDS[] = {
+     {"script",         OptionKey::ResourceType, ResourceType::Script},
+     {"image",          OptionKey::ResourceType, ResourceType::Image},
+     {"img",            OptionKey::ResourceType, ResourceType::Image},
+     {"stylesheet",     OptionKey::ResourceType, ResourceType::Stylesheet},
+     {"xmlhttprequest", OptionKey::ResourceType, ResourceType::XmlHttpRequest},
+     {"xhr",            OptionKey::ResourceType, ResourceType::XmlHttpRequest},
+     {"subdocument",    OptionKey::ResourceType, ResourceType::SubFrame},
+     {"sub_frame",      OptionKey::ResourceType, ResourceType::SubFrame},
+     {"document",       OptionKey::ResourceType, ResourceType::MainFrame},
+     {"main_frame",     OptionKey::ResourceType, ResourceType::MainFrame},
+     {"websocket",      OptionKey::ResourceType, ResourceType::WebSocket},
+     {"media",          OptionKey::ResourceType, ResourceType::Media},
+     {"font",           OptionKey::ResourceType, ResourceType::Font},
+     {"ping",           OptionKey::ResourceType, ResourceType::Ping},
+     {"other",          OptionKey::ResourceType, ResourceType::Other},
+     {"domain",         OptionKey::Domain},
+     {"domains",        OptionKey::Domains},
+     {"method",         OptionKey::Method},
+     {"request-method", OptionKey::Method},
+     {"third-party",    OptionKey::Ignored},
+     {"3p",             OptionKey::Ignored},
+     {"first-party",    OptionKey::Ignored},
+     {"1p",             OptionKey::Ignored},
+     {"important",      OptionKey::Ignored},
+     {"match-case",     OptionKey::Ignored},
+     {"popup",          OptionKey::Ignored},
+     {"object",         OptionKey::Ignored},
+     {"all",            OptionKey::Ignored},
+     {"badfilter",      OptionKey::Ignored},
+     {"csp",            OptionKey::Ignored},
+     {"redirect",       OptionKey::Ignored},
+     {"redirect-rule",  OptionKey::Ignored},
+     {"removeparam",    OptionKey::Ignored},
+     {"elemhide",       OptionKey::Ignored},
+     {"generichide",    OptionKey::Ignored},
+     {"genericblock",   OptionKey::Ignored}};
+ 
+ constexpr size_t OPTION_TABLE_SIZE = 128;   // Zweierpotenz
+ 
+ // Hash über Länge, erstes, mittleres und letztes Zeichen (FNV-1a-Schritte)
+ constexpr uint32_t option_hash(std::string_view k, uint32_t seed) {
+     uint32_t h   = seed ^ static_cast<uint32_t>(k.size());
+     auto     mix = [&h](char c) { h = (h ^ static_cast<unsigned char>(c)) * 0x01000193u; };
+     if (!k.empty()) {
+         mix(k.front());
+         mix(k[k.size() / 2]);
+         mix(k.back());
+     }
+     return (h ^ (h >> 15)) & (OPTION_TABLE_SIZE - 1);
+ }
+ 
+ constexpr uint32_t find_option_seed() {
+     for (uint32_t seed = 1; seed < 4096; ++seed) {
+         bool used[OPTION_TABLE_SIZE] = {};
+         bool ok = true;
+         for (const auto &kw : OPTION_KEYWORDS) {
+             const uint32_t slot = option_hash(kw.name, seed);
+             if (used[slot]) {
+                 ok = false;
+                 break;
+             }
+             used[slot] = true;
+         }
+         if (ok) return seed;
+     }
+     return 0;
+ }
+ 
+ constexpr uint32_t OPTION_SEED = find_option_seed();
+ static_assert(OPTION_SEED != 0, "no collision-free seed for OPTION_KEYWORDS");
+ 
+ constexpr auto OPTION_TABLE = [] {
+     std::array<OptionKeyword, OPTION_TABLE_SIZE> t{};
+     for (const auto &kw : OPTION_KEYWORDS) t[option_hash(kw.name, OPTION_SEED)] = kw;
+     return t;
+ }();
+ 
+ inline const OptionKeyword &lookup_option(std::string_view key) {
+     static constexpr OptionKeyword UNKNOWN{};
+     const OptionKeyword &e = OPTION_TABLE[option_hash(key, OPTION_SEED)];
+     return e.name == key ? e : UNKNOWN;
+ }
+ 
+ // Methode case-insensitiv suchen; Ergebnis als Bit oder 0
+ inline RequestMethodMask lookup_method(std::string_view m) {
+     for (size_t b = 0; b < SUPPORTED_METHODS.size(); ++b) {
+         const std::string_view name = SUPPORTED_METHODS[b];
+         if (name.size() != m.size()) continue;
+         bool eq = true;
+         for (size_t i = 0; eq && i < m.size(); ++i) {
+             const char c = m[i];
+             eq = (c >= 'a' && c <= 'z' ? char(c - 'a' + 'A') : c) == name[i];
+         }
+         if (eq) return static_cast<RequestMethodMask>(1u << b);
+     }
+     return 0;
+ }
+ 
  /* ------------------------------------------------------------------ *
   *  Optionen-Parser
   * ------------------------------------------------------------------ */
  
  static void parse_domain_option(
          std::string_view value,
-         std::vector<std::string_view> &includes,
-         std::vector<std::string_view> &excludes) {
+         std::pmr::vector<std::string_view> &includes,
+         std::pmr::vector<std::string_view> &excludes) {
  
      split_sv<'|'>(value, [&](std::string_view sub) {
          sub = trim(sub);
@@ -130,12 +272,12 @@
      });
  }
  
- static void parse_options(std::string_view options_sv, DnrRule &rule) {
-     // Sammelcontainer
-     std::vector<std::string_view> initiatorInc, initiatorExc;
-     std::vector<std::string_view> requestInc,   requestExc;
-     std::unordered_set<std::string> methodsInc, methodsExc;
-     std::unordered_set<std::string> resTypesInc, resTypesExc;
+ void parse_options(std::string_view options_sv, DnrRule &rule, RuleArena &arena) {
+     // Sammelcontainer (in der Arena, kein Heap)
+     std::pmr::vector<std::string_view> initiatorInc(arena.resource()), initiatorExc(arena.resource());
+     std::pmr::vector<std::string_view> requestInc(arena.resource()),   requestExc(arena.resource());
+     RequestMethodMask methodsInc  = 0, methodsExc  = 0;
+     ResourceTypeMask  resTypesInc = 0, resTypesExc = 0;
  
      split_sv<','>(options_sv, [&](std::string_view opt) {
          opt = trim(opt);
@@ -152,116 +294,191 @@
              val = trim(keyval.substr(eq + 1));
          }
  
-         // 1. Ressource-Typ?
-         if (auto it = RESOURCE_TYPE_MAP.find(key); it != RESOURCE_TYPE_MAP.end()) {
-             (neg ? resTypesExc : resTypesInc).insert(it->second);
-             return;
-         }
+         const OptionKeyword &kw = lookup_option(key);
+         switch (kw.key) {
+             case OptionKey::ResourceType:
+                 (neg ? resTypesExc : resTypesInc) |= resource_type_bit(kw.type);
+                 break;
  
-         // 2. Domains
-         if (key == "domain") {                      // initiator
-             parse_domain_option(val, initiatorInc, initiatorExc);
-             return;
-         }
-         if (key == "domains") {                     // request
-             parse_domain_option(val, requestInc, requestExc);
-             return;
-         }
+             case OptionKey::Domain:                     // initiator
+                 parse_domain_option(val, initiatorInc, initiatorExc);
+                 break;
  
-         // 3. Methoden
-         if (key == "method" || key == "request-method") {
-             split_sv<'|'>(val, [&](std::string_view m) {
-                 m = trim(m);
-                 if (m.empty()) return;
-                 std::string low(m);
-                 std::transform(low.begin(), low.end(), low.begin(), ::tolower);
-                 if (!SUPPORTED_METHODS.count(low)) return;
- 
-                 std::string up = low;
-                 std::transform(up.begin(), up.end(), up.begin(), ::toupper);
-                 (neg ? methodsExc : methodsInc).insert(std::move(up));
-             });
-             return;
-         }
+             case OptionKey::Domains:                    // request
+                 parse_domain_option(val, requestInc, requestExc);
+                 break;
  
-         // 4. Ignorierte Schlüssel (third-party/first-party etc.) -> noop
+             case OptionKey::Method:
+                 split_sv<'|'>(val, [&](std::string_view m) {
+                     (neg ? methodsExc : methodsInc) |= lookup_method(trim(m));
+                 });
+                 break;
+ 
+             case OptionKey::Ignored:                    // third-party etc.
+             case OptionKey::Unknown:
+                 break;
+         }
      });
  
      /* -- Resultate in Rule schreiben -------------------------------- */
  
-     // Ressourcentypen
-     if (!resTypesInc.empty()) {
-         rule.conditionResourceTypes = {resTypesInc.begin(), resTypesInc.end()};
-     } else if (!resTypesExc.empty()) {
-         std::vector<std::string> final;
-         final.reserve(ALL_DNR_RESOURCE_TYPES.size());
-         for (const auto &t : ALL_DNR_RESOURCE_TYPES)
-             if (!resTypesExc.count(t)) final.push_back(t);
-         if (!final.empty() && final.size() < ALL_DNR_RESOURCE_TYPES.size())
-             rule.conditionResourceTypes = std::move(final);
-     }
+     // Ressourcentypen: Includes gewinnen, sonst Komplement der Excludes
+     // (alle ausgeschlossen → keine Kondition)
+     if (resTypesInc)
+         rule.conditionResourceTypes = resTypesInc;
+     else if (resTypesExc)
+         rule.conditionResourceTypes = ALL_RESOURCE_TYPES_MASK & ~resTypesExc;
  
-     // Initiator- / Request-Domains
-     if (!initiatorInc.empty())
-         rule.conditionInitiatorDomains = to_string_vector_unique(initiatorInc);
-     if (!initiatorExc.empty()) {
-         if (rule.conditionInitiatorDomains) rule.conditionInitiatorDomains.reset();
-         rule.conditionExcludedInitiatorDomains =
-             to_string_vector_unique(initiatorExc);
-     }
+     // Initiator- / Request-Domains: Excludes verdrängen Includes
+     if (!initiatorExc.empty())
+         rule.conditionExcludedInitiatorDomains = unique_list(initiatorExc, arena);
+     else if (!initiatorInc.empty())
+         rule.conditionInitiatorDomains = unique_list(initiatorInc, arena);
+ 
+     if (!requestExc.empty())
+         rule.conditionExcludedRequestDomains = unique_list(requestExc, arena);
+     else if (!requestInc.empty())
+         rule.conditionRequestDomains = unique_list(requestInc, arena);
+ 
+     // Methoden: Excludes verdrängen Includes
+     rule.conditionRequestMethods         = methodsExc ? 0 : methodsInc;
+     rule.conditionExcludedRequestMethods = methodsExc;
+ }
+ 
+ /* ------------------------------------------------------------------ *
+  *  Fast-Path für "||host^"
+  *
+  *  Der mit Abstand häufigste Regeltyp (nackte Domain ohne Optionen)
+  *  braucht weder Options-Parser noch generische urlFilter-Konstruktion
+  *  noch die Konditions-Prüfungen.  Alles, was kein schlichter Hostname
+  *  ist, läuft weiter über den generischen Pfad – die Ausgabe ist in
+  *  beiden Fällen identisch.
+  * ------------------------------------------------------------------ */
+ 
+ // ASCII-Buchstaben, Ziffern, '-', '.', '_' sowie Bytes >= 0x80 (IDN)
+ static constexpr std::array<bool, 256> HOST_CHARS = [] {
+     std::array<bool, 256> t{};
+     for (int c = 'a'; c <= 'z'; ++c) t[c] = true;
+     for (int c = 'A'; c <= 'Z'; ++c) t[c] = true;
+     for (int c = '0'; c <= '9'; ++c) t[c] = true;
+     t['-'] = t['.'] = t['_'] = true;
+     for (int c = 0x80; c < 256; ++c) t[c] = true;
+     return t;
+ }();
  
-     if (!requestInc.empty())
-         rule.conditionRequestDomains = to_string_vector_unique(requestInc);
-     if (!requestExc.empty()) {
-         if (rule.conditionRequestDomains) rule.conditionRequestDomains.reset();
-         rule.conditionExcludedRequestDomains =
-             to_string_vector_unique(requestExc);
+ static bool is_plain_host(std::string_view host) {
+     if (host.empty() || host.front() == '.' || host.front() == '-') return false;
+     for (const char c : host)
+         if (!HOST_CHARS[static_cast<unsigned char>(c)]) return false;
+     return true;
+ }
+ 
+ // Host der Zeile, falls sie die Form "||host^" ohne Optionen hat, sonst leer
+ static std::string_view plain_domain(std::string_view line, const LineClass &cls) {
+     if (cls.dollar != std::string_view::npos || cls.slash || cls.star ||
+         line.size() <= 3 || !line.starts_with("||") || line.back() != '^')
+         return {};
+     const std::string_view host = line.substr(2, line.size() - 3);
+     return is_plain_host(host) ? host : std::string_view{};
+ }
+ 
+ static void fill_domain_block_rule(DnrRule &rule, std::string_view host, RuleArena &arena) {
+     rule.conditionUrlFilter = canonical_url_filter(arena.concat({"||", host, "/"}), arena);
+ }
+ 
+ /* ------------------------------------------------------------------ *
+  *  Kanonische urlFilter
+  *
+  *  Dieselbe URL-Menge lässt sich als urlFilter vielfach schreiben
+  *  ("abc", "*abc*", "|*abc", "ABC", "abc**^").  Die Normalform macht
+  *  gleichbedeutende Regeln für die Deduplizierung gleich und spart
+  *  Chrome Speicher:
+  *    – Kleinschreibung (Chrome vergleicht case-insensitiv, isUrlFilter-
+  *      CaseSensitive setzt der Parser nie)
+  *    – '*'-Folgen werden ein '*'
+  *    – '*' am Anfang bzw. Ende entfällt samt '|'-Anker davor/dahinter;
+  *      "*^" am Ende ebenfalls ('^' trifft auch das URL-Ende)
+  *    – was dann leer ist, trifft jede URL und wird "*"
+  *  "||" bleibt stehen ("||*x" verlangt x hinter dem Host-Anfang), ein
+  *  wörtliches '|' am Rand behält seinen '*' davor bzw. dahinter, damit
+  *  es nicht zum Anker wird.  "||host^" und "||host/" sind nicht gleich
+  *  (Ports) – die Abdeckung regelt prune_subsumed_rules.
+  * ------------------------------------------------------------------ */
+ 
+ std::string_view canonical_url_filter(std::string_view filter, RuleArena &arena) {
+     std::string_view anchor, body = filter;
+     if (body.starts_with("||"))     anchor = body.substr(0, 2);
+     else if (body.starts_with('|')) anchor = body.substr(0, 1);
+     body.remove_prefix(anchor.size());
+     bool rightAnchor = !body.empty() && body.back() == '|';
+     if (rightAnchor) body.remove_suffix(1);
+ 
+     // Ränder kürzen (alles Teil-Views von filter)
+     for (;;) {
+         if (body.ends_with("*^")) {
+             body.remove_suffix(1);
+         } else if (body.ends_with('*') && !body.ends_with("|*") &&
+                    (body.size() > 1 || anchor.size() != 2)) {
+             body.remove_suffix(1);
+             rightAnchor = false;
+         } else {
+             break;
+         }
      }
+     if (anchor.size() == 1 && body.starts_with('*')) anchor = {};
+     if (anchor.empty())
+         while (body.starts_with('*') && body.size() > 1 && body[1] != '|') body.remove_prefix(1);
+     if (body.empty() && anchor.size() != 2) return "*";
+     if (body == "*" && anchor.empty()) return "*";
  
-     // Methoden
-     if (!methodsInc.empty()) {
-         rule.conditionRequestMethods = {methodsInc.begin(), methodsInc.end()};
-         std::sort(rule.conditionRequestMethods->begin(),
-                   rule.conditionRequestMethods->end());
+     // Ohne Großbuchstaben, "**" und Lücken zu den Ankern reicht ein View
+     bool copy = (!anchor.empty() && anchor.data() + anchor.size() != body.data()) ||
+                 (rightAnchor && body.data() + body.size() + 1 != filter.data() + filter.size());
+     for (size_t i = 0; i < body.size() && !copy; ++i)
+         copy = (body[i] >= 'A' && body[i] <= 'Z') || (body[i] == '*' && i && body[i - 1] == '*');
+     if (!copy) {
+         const char *begin = anchor.empty() ? body.data() : anchor.data();
+         const char *end   = body.data() + body.size() + (rightAnchor ? 1 : 0);
+         return {begin, static_cast<size_t>(end - begin)};
      }
-     if (!methodsExc.empty()) {
-         if (rule.conditionRequestMethods) rule.conditionRequestMethods.reset();
-         rule.conditionExcludedRequestMethods =
-             {methodsExc.begin(), methodsExc.end()};
-         std::sort(rule.conditionExcludedRequestMethods->begin(),
-                   rule.conditionExcludedRequestMethods->end());
+ 
+     char  *out = arena.allocate<char>(anchor.size() + body.size() + 1);
+     size_t n   = 0;
+     for (const char c : anchor) out[n++] = c;
+     for (size_t i = 0; i < body.size(); ++i) {
+         const char c = body[i];
+         if (c == '*' && i && body[i - 1] == '*') continue;
+         out[n++] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
      }
+     if (rightAnchor) out[n++] = '|';
+     return {out, n};
  }
  
  /* ------------------------------------------------------------------ *
   *  Einzelne Zeile parsen
   * ------------------------------------------------------------------ */
  
- static std::optional<DnrRule> parse_line(std::string_view line, int id) {
-     line = trim(line);
-     if (line.empty() || line.starts_with('!') || line.starts_with('[')) return {};
- 
-     // Cosmetic/HTML-Regeln überspringen
-     if (line.find("##") != std::string_view::npos ||
-         line.find("#?#") != std::string_view::npos ||
-         line.find("#$#") != std::string_view::npos ||
-         line.find("#@#") != std::string_view::npos)
-         return {};
- 
+ // Generischer Pfad für eine getrimmte, als Netzwerk-Regel klassifizierte Zeile
+ static std::optional<DnrRule> parse_network_line(std::string_view line,
+                                                  const LineClass &cls, int id,
+                                                  RuleArena &arena) {
      DnrRule rule;
      rule.id = id;
  
      /* -------- Ausnahme-Regel? (allow) ----------------------------- */
+     size_t posDollar = cls.dollar;
      if (line.starts_with("@@")) {
          rule.actionType = "allow";
          rule.priority   = 2;
-         line            = trim(line.substr(2));
-         if (line.empty()) return {};
+         const std::string_view rest = trim(line.substr(2));
+         if (rest.empty()) return {};
+         if (posDollar != std::string_view::npos)
+             posDollar -= static_cast<size_t>(rest.data() - line.data());
+         line = rest;
      }
  
      /* -------- $-Optionen abtrennen -------------------------------- */
      std::string_view filterPart = line, optionsPart;
-     const size_t posDollar      = line.find('$');
      if (posDollar != std::string_view::npos) {
          filterPart  = line.substr(0, posDollar);
          optionsPart = line.substr(posDollar + 1);
@@ -273,59 +490,40 @@
      if (filterPart.size() > 2 && filterPart.front() == '/' &&
          filterPart.back() == '/' && !filterPart.starts_with("||")) {
  
-         rule.conditionRegexFilter =
-             std::string(filterPart.substr(1, filterPart.size() - 2));
+         rule.conditionRegexFilter = filterPart.substr(1, filterPart.size() - 2);
      } else { /* ---- URL-Filter konstruieren ------------------------ */
          if (filterPart.starts_with("||") && filterPart.ends_with('^')) {
              std::string_view domain = filterPart.substr(2, filterPart.size() - 3);
-             if (!domain.empty() && domain.find('/') == std::string_view::npos &&
-                 domain.find('*') == std::string_view::npos) {
-                 rule.conditionUrlFilter = "||" + std::string(domain) + "/";
+             if (!domain.empty() && !cls.slash && !cls.star) {
+                 rule.conditionUrlFilter = canonical_url_filter(arena.concat({"||", domain, "/"}), arena);
              } else
                  return {};
          } else if (filterPart.starts_with("||")) {
              std::string_view domain = filterPart.substr(2);
-             if (!domain.empty() && domain.find('/') == std::string_view::npos &&
-                 domain.find('*') == std::string_view::npos) {
-                 rule.conditionUrlFilter = "||" + std::string(domain) + "^";
+             if (!domain.empty() && !cls.slash && !cls.star) {
+                 rule.conditionUrlFilter = canonical_url_filter(arena.concat({"||", domain, "^"}), arena);
              } else
                  return {};
          } else {
-             const bool startAnchor = filterPart.starts_with('|');
-             const bool endAnchor   = filterPart.ends_with('|');
- 
-             std::string_view core = filterPart;
-             if (startAnchor) core = core.substr(1);
-             if (endAnchor && core.size()) core = core.substr(0, core.size() - 1);
- 
-             std::string urlFilter;
-             urlFilter.reserve(core.size() + 2);
-             if (!startAnchor) urlFilter.push_back('*');
-             urlFilter.append(core);
-             if (!endAnchor) urlFilter.push_back('*');
- 
-             if (urlFilter == "*" || urlFilter == "**") {
-                 rule.conditionUrlFilter = "*";
-             } else {
-                 rule.conditionUrlFilter = std::move(urlFilter);
-             }
+             // Adblock-Muster und urlFilter teilen '|', '*' und '^'
+             rule.conditionUrlFilter = canonical_url_filter(filterPart, arena);
          }
      }
  
      /* -------- Optionen verarbeiten -------------------------------- */
-     if (!optionsPart.empty()) parse_options(optionsPart, rule);
+     if (!optionsPart.empty()) parse_options(optionsPart, rule, arena);
  
      /* -------- Mindest-Konditionen erfüllt? ------------------------ */
      const bool hasCondition =
          rule.conditionUrlFilter.has_value() ||
          rule.conditionRegexFilter.has_value() ||
-         rule.conditionResourceTypes.has_value() ||
-         rule.conditionRequestDomains.has_value() ||
-         rule.conditionExcludedRequestDomains.has_value() ||
-         rule.conditionInitiatorDomains.has_value() ||
-         rule.conditionExcludedInitiatorDomains.has_value() ||
-         rule.conditionRequestMethods.has_value() ||
-         rule.conditionExcludedRequestMethods.has_value();
+         rule.conditionResourceTypes != 0 ||
+         !rule.conditionRequestDomains.empty() ||
+         !rule.conditionExcludedRequestDomains.empty() ||
+         !rule.conditionInitiatorDomains.empty() ||
+         !rule.conditionExcludedInitiatorDomains.empty() ||
+         rule.conditionRequestMethods != 0 ||
+         rule.conditionExcludedRequestMethods != 0;
  
      if (!hasCondition) return {};
  
@@ -333,17 +531,50 @@
      // domains. Wenn beides fehlt, verwerfen.
      if (rule.actionType == "allow" &&
          !rule.conditionUrlFilter && !rule.conditionRegexFilter &&
-         !rule.conditionRequestDomains)
+         rule.conditionRequestDomains.empty())
          return {};
  
      return rule;
  }
  
+ std::optional<DnrRule> parse_line(std::string_view line, int id, RuleArena &arena) {
+     line = trim(line);
+ 
+     // Kommentare und Cosmetic/HTML-Regeln in einem Durchlauf aussortieren
+     const LineClass cls = classify_line(line);
+     if (cls.kind != LineKind::Network) return {};
+ 
+     if (const auto host = plain_domain(line, cls); !host.empty()) {
+         std::optional<DnrRule> rule{std::in_place};
+         rule->id = id;
+         fill_domain_block_rule(*rule, host, arena);
+         return rule;
+     }
+     return parse_network_line(line, cls, id, arena);
+ }
+ 
  /* ------------------------------------------------------------------ *
   *  Serialisierung
   * ------------------------------------------------------------------ */
  
- static json rule_to_json(const DnrRule &r) {
+ // DOM-basierte Referenz-Serialisierung.  Die Ausgabe der Entry-Points
+ // läuft über write_rule_json (unten); rule_to_json bleibt als Vergleich
+ // für Benchmarks und Gegenproben.
+ template <size_t N>
+ static json mask_to_json(unsigned mask, const std::array<std::string_view, N> &names) {
+     json arr = json::array();
+     for (size_t b = 0; b < N; ++b)
+         if (mask & (1u << b)) arr.push_back(names[b]);
+     return arr;
+ }
+ 
+ static json list_to_json(DomainList list, const DomainTable &domains) {
+     json arr = json::array();
+     for (const auto d : list) arr.push_back(domains[d]);
+     return arr;
+ }
+ 
+ json rule_to_json(const DnrRule &r, const DomainTable &domains) {
      json j;
      j["id"]       = r.id;
      j["priority"] = r.priority;
@@ -352,58 +583,590 @@
      json cond = json::object();
      if (r.conditionRegexFilter)      cond["regexFilter"]          = *r.conditionRegexFilter;
      if (r.conditionUrlFilter)        cond["urlFilter"]            = *r.conditionUrlFilter;
-     if (r.conditionResourceTypes)    cond["resourceTypes"]        = *r.conditionResourceTypes;
-     if (r.conditionRequestDomains)   cond["requestDomains"]       = *r.conditionRequestDomains;
-     if (r.conditionExcludedRequestDomains)
-         cond["excludedRequestDomains"] = *r.conditionExcludedRequestDomains;
-     if (r.conditionInitiatorDomains) cond["initiatorDomains"]     = *r.conditionInitiatorDomains;
-     if (r.conditionExcludedInitiatorDomains)
-         cond["excludedInitiatorDomains"] = *r.conditionExcludedInitiatorDomains;
-     if (r.conditionRequestMethods)   cond["requestMethods"]       = *r.conditionRequestMethods;
+     if (r.conditionResourceTypes)
+         cond["resourceTypes"] = mask_to_json(r.conditionResourceTypes, ALL_DNR_RESOURCE_TYPES);
+     if (!r.conditionRequestDomains.empty())
+         cond["requestDomains"] = list_to_json(r.conditionRequestDomains, domains);
+     if (!r.conditionExcludedRequestDomains.empty())
+         cond["excludedRequestDomains"] = list_to_json(r.conditionExcludedRequestDomains, domains);
+     if (!r.conditionInitiatorDomains.empty())
+         cond["initiatorDomains"] = list_to_json(r.conditionInitiatorDomains, domains);
+     if (!r.conditionExcludedInitiatorDomains.empty())
+         cond["excludedInitiatorDomains"] = list_to_json(r.conditionExcludedInitiatorDomains, domains);
+     if (r.conditionRequestMethods)
+         cond["requestMethods"] = mask_to_json(r.conditionRequestMethods, SUPPORTED_METHODS);
      if (r.conditionExcludedRequestMethods)
-         cond["excludedRequestMethods"] = *r.conditionExcludedRequestMethods;
+         cond["excludedRequestMethods"] =
+             mask_to_json(r.conditionExcludedRequestMethods, SUPPORTED_METHODS);
  
      if (!cond.empty()) j["condition"] = std::move(cond);
      return j;
  }
  
+ /* ------------------------------------------------------------------ *
+  *  Direkte Serialisierung (ohne DOM)
+  *
+  *  Schreibt exakt dieselben Bytes wie rule_to_json(r).dump() mit
+  *  error_handler_t::ignore: Schlüssel in der Sortierung von
+  *  nlohmann::json (std::map), ungültige UTF-8-Sequenzen werden
+  *  verworfen, Steuerzeichen als \uXXXX escaped.
+  * ------------------------------------------------------------------ */
+ 
+ // Länge einer gültigen UTF-8-Sequenz ab s[i], sonst 0.  Bei 0 ist in
+ // `bad` die Position des ersten ungültigen Bytes abgelegt.
+ static size_t utf8_sequence(std::string_view s, size_t i, size_t &bad) {
+     const auto b0 = static_cast<unsigned char>(s[i]);
+     size_t     len;
+     unsigned char lo = 0x80, hi = 0xBF;            // Bereich 2. Byte
+     if (b0 >= 0xC2 && b0 <= 0xDF)      len = 2;
+     else if (b0 >= 0xE0 && b0 <= 0xEF) len = 3, lo = b0 == 0xE0 ? 0xA0 : 0x80,
+                                                  hi = b0 == 0xED ? 0x9F : 0xBF;
+     else if (b0 >= 0xF0 && b0 <= 0xF4) len = 4, lo = b0 == 0xF0 ? 0x90 : 0x80,
+                                                  hi = b0 == 0xF4 ? 0x8F : 0xBF;
+     else {
+         bad = i;
+         return 0;
+     }
+     for (size_t k = 1; k < len; ++k) {
+         if (i + k >= s.size()) {
+             bad = s.size();
+             return 0;
+         }
+         const auto b = static_cast<unsigned char>(s[i + k]);
+         if (b < (k == 1 ? lo : 0x80) || b > (k == 1 ? hi : 0xBF)) {
+             bad = i + k;
+             return 0;
+         }
+     }
+     return len;
+ }
+ 
+ static void append_json_string(std::string &out, std::string_view s) {
+     static constexpr char HEX[] = "0123456789abcdef";
+     out.push_back('"');
+     size_t i = 0;
+     while (i < s.size()) {
+         // Lauf unkritischer ASCII-Bytes am Stück kopieren
+         size_t run = i;
+         while (run < s.size()) {
+             const auto c = static_cast<unsigned char>(s[run]);
+             if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\') break;
+             ++run;
+         }
+         out.append(s.data() + i, run - i);
+         i = run;
+         if (i == s.size()) break;
+ 
+         const auto c = static_cast<unsigned char>(s[i]);
+         if (c >= 0x80) {
+             size_t bad = 0;
+             if (const size_t len = utf8_sequence(s, i, bad)) {
+                 out.append(s.data() + i, len);
+                 i += len;
+             } else {
+                 // wie nlohmann: ungültiges Startbyte überspringen, sonst
+                 // das störende Byte als neuen Anfang erneut prüfen
+                 i = bad == i ? i + 1 : bad;
+             }
+             continue;
+         }
+         switch (c) {
+             case '"':  out += "\\\""; break;
+             case '\\': out += "\\\\"; break;
+             case '\b': out += "\\b"; break;
+             case '\t': out += "\\t"; break;
+             case '\n': out += "\\n"; break;
+             case '\f': out += "\\f"; break;
+             case '\r': out += "\\r"; break;
+             default:
+                 out += "\\u00";
+                 out.push_back(HEX[c >> 4]);
+                 out.push_back(HEX[c & 0xF]);
+         }
+         ++i;
+     }
+     out.push_back('"');
+ }
+ 
+ static void append_int(std::string &out, int v) {
+     char buf[16];
+     const auto res = std::to_chars(buf, buf + sizeof buf, v);
+     out.append(buf, res.ptr);
+ }
+ 
+ // Kürzeste exakte Darstellung; ganze Zahlen mit ".0" wie nlohmann::json
+ static void append_double(std::string &out, double v) {
+     char buf[32];
+     const auto res = std::to_chars(buf, buf + sizeof buf, v);
+     out.append(buf, res.ptr);
+     if (std::find_if(buf, res.ptr, [](char c) { return c == '.' || c == 'e'; }) == res.ptr)
+         out += ".0";
+ }
+ 
+ // Bitmaske als Array der gesetzten Namen.  Ressourcentypen und Methoden
+ // stammen aus festen ASCII-Tabellen und brauchen kein Escaping.
+ template <size_t N>
+ static void append_mask_array(std::string &out, unsigned mask,
+                               const std::array<std::string_view, N> &names) {
+     out.push_back('[');
+     bool first = true;
+     for (size_t b = 0; b < N; ++b) {
+         if (!(mask & (1u << b))) continue;
+         if (!first) out.push_back(',');
+         out.push_back('"');
+         out += names[b];
+         out.push_back('"');
+         first = false;
+     }
+     out.push_back(']');
+ }
+ 
+ static void append_domain_array(std::string &out, DomainList v, const DomainTable &domains) {
+     out.push_back('[');
+     for (size_t i = 0; i < v.size(); ++i) {
+         if (i) out.push_back(',');
+         append_json_string(out, domains[v[i]]);
+     }
+     out.push_back(']');
+ }
+ 
+ void write_rule_json(std::string &out, const DnrRule &r, const DomainTable &domains) {
+     if (r.actionType == "block")
+         out += "{\"action\":{\"type\":\"block\"}";
+     else if (r.actionType == "allow")
+         out += "{\"action\":{\"type\":\"allow\"}";
+     else {
+         out += "{\"action\":{\"type\":";
+         append_json_string(out, r.actionType);
+         out.push_back('}');
+     }
+ 
+     // Schlüssel alphabetisch wie std::map in nlohmann::json
+     bool first = true;
+     auto key = [&](std::string_view k) {
+         out += first ? ",\"condition\":{\"" : ",\"";
+         out += k;
+         out += "\":";
+         first = false;
+     };
+     if (!r.conditionExcludedInitiatorDomains.empty()) {
+         key("excludedInitiatorDomains");
+         append_domain_array(out, r.conditionExcludedInitiatorDomains, domains);
+     }
+     if (!r.conditionExcludedRequestDomains.empty()) {
+         key("excludedRequestDomains");
+         append_domain_array(out, r.conditionExcludedRequestDomains, domains);
+     }
+     if (r.conditionExcludedRequestMethods) {
+         key("excludedRequestMethods");
+         append_mask_array(out, r.conditionExcludedRequestMethods, SUPPORTED_METHODS);
+     }
+     if (!r.conditionInitiatorDomains.empty()) {
+         key("initiatorDomains");
+         append_domain_array(out, r.conditionInitiatorDomains, domains);
+     }
+     if (r.conditionRegexFilter) {
+         key("regexFilter");
+         append_json_string(out, *r.conditionRegexFilter);
+     }
+     if (!r.conditionRequestDomains.empty()) {
+         key("requestDomains");
+         append_domain_array(out, r.conditionRequestDomains, domains);
+     }
+     if (r.conditionRequestMethods) {
+         key("requestMethods");
+         append_mask_array(out, r.conditionRequestMethods, SUPPORTED_METHODS);
+     }
+     if (r.conditionResourceTypes) {
+         key("resourceTypes");
+         append_mask_array(out, r.conditionResourceTypes, ALL_DNR_RESOURCE_TYPES);
+     }
+     if (r.conditionUrlFilter) {
+         key("urlFilter");
+         append_json_string(out, *r.conditionUrlFilter);
+     }
+     if (!first) out.push_back('}');
+ 
+     out += ",\"id\":";
+     append_int(out, r.id);
+     out += ",\"priority\":";
+     append_int(out, r.priority);
+     out.push_back('}');
+ }
+ 
+ /* ------------------------------------------------------------------ *
+  *  Chunk-Verarbeitung
+  *
+  *  Ein Chunk ist ein zeilenbündiger Ausschnitt der Liste.  parse_lines
+  *  vergibt noch keine IDs; die werden erst nach dem Zusammenführen
+  *  und den Optimierungs-Pässen (optimize.h) fortlaufend gesetzt, damit
+  *  sequentieller, paralleler und inkrementeller Pfad byte-identisch
+  *  sind.  Bis dahin trägt jede Regel ihre Zeilennummer als ID (für
+  *  Diagnosen der Pässe), relativ zum Chunk-Anfang.
+  * ------------------------------------------------------------------ */
+ 
+ // urlFilter/regexFilter, die noch in text zeigen, in die Arena holen
+ static void copy_filters(DnrRule &rule, std::string_view text, RuleArena &arena) {
+     auto inside = [&](std::string_view s) {
+         return !std::less<const char *>{}(s.data(), text.data()) &&
+                std::less<const char *>{}(s.data(), text.data() + text.size());
+     };
+     if (rule.conditionUrlFilter && inside(*rule.conditionUrlFilter))
+         rule.conditionUrlFilter = arena.copy(*rule.conditionUrlFilter);
+     if (rule.conditionRegexFilter && inside(*rule.conditionRegexFilter))
+         rule.conditionRegexFilter = arena.copy(*rule.conditionRegexFilter);
+ }
+ 
+ // copyFilters: text lebt kürzer als die Regeln; was eine Regel daraus
+ // behält, kommt in die Arena (Domains stehen ohnehin in deren Tabelle)
+ static void parse_lines(std::string_view text, bool skipBom, ParsedChunk &into, bool copyFilters = false) {
+     LineSplitter     lines(text, skipBom);
+     std::string_view line;
+     while (lines.next(line)) {
+         ++into.totalLines;
+         line = trim(line);
+         const LineClass cls = classify_line(line);
+         if (cls.kind != LineKind::Network) {
+             ++into.skippedLines;
+             continue;
+         }
+         // Fast-Path: Regel direkt im Zielvektor anlegen, ohne Umweg
+         // über std::optional und den generischen Parser
+         if (const auto host = plain_domain(line, cls); !host.empty()) {
+             DnrRule &rule = into.rules.emplace_back();
+             fill_domain_block_rule(rule, host, *into.arena);
+             rule.id = into.totalLines;
+             continue;
+         }
+         if (auto rule = parse_network_line(line, cls, into.totalLines, *into.arena)) {
+             if (copyFilters) copy_filters(*rule, text, *into.arena);
+             into.rules.push_back(std::move(*rule));
+         } else
+             ++into.skippedLines;
+     }
+ }
+ 
+ static ParsedChunk parse_chunk(std::string_view text, bool skipBom) {
+     ParsedChunk chunk;
+     parse_lines(text, skipBom, chunk);
+     return chunk;
+ }
+ 
+ static void assign_ids(std::vector<DnrRule> &rules, int firstId) {
+     for (auto &r : rules) r.id = firstId++;
+ }
+ 
+ // Regeln komma-getrennt (ohne Klammern) anhängen
+ static void append_rules_json(std::string &out, std::span<const DnrRule> rules,
+                               const DomainTable &domains) {
+     out.reserve(out.size() + rules.size() * 96);
+     for (const auto &r : rules) {
+         if (!out.empty()) out.push_back(',');
+         write_rule_json(out, r, domains);
+     }
+ }
+ 
+ // {"coverageLoss":..,"dropped":[{"allow":..,"line":..,"weight":..}],...}
+ static void append_budget_report(std::string &out, const BudgetReport &report) {
+     out += "{\"coverageLoss\":";
+     append_double(out, report.totalWeight > 0 ? report.droppedWeight / report.totalWeight : 0.0);
+     out += ",\"dropped\":[";
+     for (size_t i = 0; i < report.dropped.size(); ++i) {
+         const auto &d = report.dropped[i];
+         if (i) out.push_back(',');
+         out += d.allow ? "{\"allow\":true,\"line\":" : "{\"allow\":false,\"line\":";
+         append_int(out, d.line);
+         out += ",\"weight\":";
+         append_double(out, d.weight);
+         out.push_back('}');
+     }
+     out += "],\"droppedWeight\":";
+     append_double(out, report.droppedWeight);
+     out += ",\"totalWeight\":";
+     append_double(out, report.totalWeight);
+     out.push_back('}');
+ }
+ 
+ static std::string make_output(std::string_view rulesBody, int totalLines,
+                                int processedRules, int skippedLines,
+                                const OptimizeStats &opt, const OptimizeOptions &options) {
+     const bool shadowReport = options.reportShadowed;
+     std::string out;
+     out.reserve(rulesBody.size() + 128 + (shadowReport ? opt.shadowed.size() * 32 : 0) +
+                 opt.budget.dropped.size() * 48 + opt.rejected.size() * 40);
+     out += '{';
+     if (options.maxRules > 0) {
+         out += "\"budgetReport\":";
+         append_budget_report(out, opt.budget);
+         out += ',';
+     }
+     if (!opt.rejected.empty()) {
+         out += "\"regexReport\":[";
+         for (size_t i = 0; i < opt.rejected.size(); ++i) {
+             if (i) out.push_back(',');
+             out += "{\"line\":";
+             append_int(out, opt.rejected[i].line);
+             out += ",\"reason\":\"";
+             out += opt.rejected[i].reason;
+             out += "\"}";
+         }
+         out += "],";
+     }
+     out += "\"rules\":[";
+     out += rulesBody;
+     out += ']';
+     if (shadowReport) {
+         out += ",\"shadowReport\":[";
+         for (size_t i = 0; i < opt.shadowed.size(); ++i) {
+             if (i) out.push_back(',');
+             out += "{\"allowLine\":";
+             append_int(out, opt.shadowed[i].allowLine);
+             out += ",\"line\":";
+             append_int(out, opt.shadowed[i].line);
+             out.push_back('}');
+         }
+         out += ']';
+     }
+     out += ",\"stats\":{\"coalescedRules\":";
+     append_int(out, opt.coalescedRules);
+     out += ",\"droppedRules\":";
+     append_int(out, opt.droppedRules);
+     out += ",\"duplicateRules\":";
+     append_int(out, opt.duplicateRules);
+     out += ",\"loweredRegexRules\":";
+     append_int(out, opt.loweredRegexRules);
+     out += ",\"parsedRules\":";
+     append_int(out, opt.parsedRules);
+     out += ",\"processedRules\":";
+     append_int(out, processedRules);
+     out += ",\"rejectedRegexRules\":";
+     append_int(out, opt.rejectedRegexRules);
+     out += ",\"shadowedRules\":";
+     append_int(out, opt.shadowedRules);
+     out += ",\"skippedLines\":";
+     append_int(out, skippedLines);
+     out += ",\"subsumedRules\":";
+     append_int(out, opt.subsumedRules);
+     out += ",\"totalLines\":";
+     append_int(out, totalLines);
+     out += "}}";
+     return out;
+ }
+ 
  /* ------------------------------------------------------------------ *
   *  Haupt-Entry-Point für JavaScript (WASM)
   * ------------------------------------------------------------------ */
  
- std::string parseFilterListWasm(std::string filterListText) {
-     json rules = json::array();
- 
-     int   totalLines     = 0;
-     int   skippedLines   = 0;
-     int   processedRules = 0;
-     int   id             = 1;
- 
-     std::stringstream ss(std::move(filterListText));
-     std::string        buf;
-     while (std::getline(ss, buf, '\n')) {
-         ++totalLines;
-         if (auto rule = parse_line(buf, id)) {
-             rules.push_back(rule_to_json(*rule));
-             ++processedRules;
-             ++id;
-         } else {
-             ++skippedLines;
+ static std::string finish_chunk(ParsedChunk &chunk, const OptimizeOptions &options) {
+     OptimizeStats opt;
+     optimize_rules(chunk.rules, *chunk.arena, options, opt);
+     assign_ids(chunk.rules, 1);
+ 
+     std::string body;
+     append_rules_json(body, chunk.rules, chunk.arena->domains());
+     return make_output(body, chunk.totalLines,
+                        static_cast<int>(chunk.rules.size()), chunk.skippedLines, opt, options);
+ }
+ 
+ std::string parseFilterList(std::string_view filterListText, const OptimizeOptions &options) {
+     ParsedChunk chunk = parse_chunk(filterListText, true);
+     return finish_chunk(chunk, options);
+ }
+ 
+ std::string parseFilterListWasm(std::string filterListText, size_t maxRules) {
+     OptimizeOptions options;
+     options.maxRules = maxRules;
+     return parseFilterList(filterListText, options);
+ }
+ 
+ #ifndef __EMSCRIPTEN__
+ ParsedChunk compileFilterList(std::string_view filterListText, const OptimizeOptions &options,
+                               OptimizeStats &stats) {
+     ParsedChunk chunk = parse_chunk(filterListText, true);
+     optimize_rules(chunk.rules, *chunk.arena, options, stats);
+     return chunk;
+ }
+ #endif
+ 
+ /* ------------------------------------------------------------------ *
+  *  Inkrementeller Parser (feed/finish)
+  *
+  *  Der Chunk gehört JavaScript und lebt nur während feed().  Die
+  *  vollständigen Zeilen werden direkt aus ihm geparst; in die Arena
+  *  kommen nur urlFilter und regexFilter der Regeln, nicht Kommentare
+  *  und Cosmetic-Zeilen.  Die angebrochene letzte Zeile wartet in
+  *  carry_ und wird, sobald ihr Ende da ist, für sich geparst.
+  * ------------------------------------------------------------------ */
+ 
+ void FilterListParser::feed(const std::string &chunk) {
+     const std::string_view data   = chunk;
+     const size_t           lastNl = data.rfind('\n');
+     if (lastNl == std::string_view::npos) {
+         carry_.append(data);
+         return;
+     }
+     std::string_view lines = data.substr(0, lastNl + 1);
+     if (!carry_.empty()) {
+         const size_t firstNl = lines.find('\n');
+         carry_.append(lines.substr(0, firstNl + 1));
+         parse_lines(carry_, !bomChecked_, parsed_, true);
+         bomChecked_ = true;
+         lines.remove_prefix(firstNl + 1);
+     }
+     if (!lines.empty()) {
+         parse_lines(lines, !bomChecked_, parsed_, true);
+         bomChecked_ = true;
+     }
+     carry_.assign(data.substr(lastNl + 1));
+ }
+ 
+ std::string FilterListParser::finish() {
+     // carry_ lebt bis nach der Serialisierung, keine Kopie nötig
+     if (!carry_.empty()) parse_lines(carry_, !bomChecked_, parsed_);
+ 
+     std::string out = finish_chunk(parsed_, options_);
+     carry_.clear();
+     carry_.shrink_to_fit();
+     parsed_     = {};
+     bomChecked_ = false;
+     return out;
+ }
+ 
+ /* ------------------------------------------------------------------ *
+  *  Paralleler Pfad (nur nativ)
+  *
+  *  1. Eingabe an Zeilengrenzen in Chunks zerlegen
+  *  2. Chunks parallel parsen
+  *  3. Regeln in Reihenfolge zusammenführen, Optimierungs-Pässe und
+  *     ID-Vergabe sequentiell (wie im sequentiellen Pfad)
+  *  4. Abschnitte parallel serialisieren, dann verketten
+  * ------------------------------------------------------------------ */
+ 
+ #ifndef __EMSCRIPTEN__
+ 
+ // Einfacher Pool: jeder Worker zieht Indizes aus einem gemeinsamen Zähler.
+ template <typename Fn>
+ static void parallel_for(size_t n, unsigned threads, Fn &&fn) {
+     std::atomic<size_t> next{0};
+     auto worker = [&] {
+         for (size_t i; (i = next.fetch_add(1)) < n;) fn(i);
+     };
+     std::vector<std::thread> pool;
+     const size_t workers = std::min<size_t>(threads, n);
+     for (size_t t = 1; t < workers; ++t) pool.emplace_back(worker);
+     worker();
+     for (auto &t : pool) t.join();
+ }
+ 
+ // Domain-IDs der Regeln aus der Tabelle `from` in die von arena
+ // übertragen; die umgeschriebenen Listen liegen in arena
+ static void remap_domains(std::vector<DnrRule> &rules, const DomainTable &from, RuleArena &arena) {
+     std::vector<DomainId> map(from.size());
+     for (DomainId id = 0; id < map.size(); ++id) map[id] = arena.domains().intern(from[id]);
+ 
+     auto remap = [&](DomainList &list) {
+         if (list.empty()) return;
+         DomainId *out = arena.allocate<DomainId>(list.size());
+         std::transform(list.begin(), list.end(), out, [&map](DomainId d) { return map[d]; });
+         list = {out, list.size()};
+     };
+     for (auto &r : rules) {
+         remap(r.conditionRequestDomains);
+         remap(r.conditionExcludedRequestDomains);
+         remap(r.conditionInitiatorDomains);
+         remap(r.conditionExcludedInitiatorDomains);
+     }
+ }
+ 
+ std::string parseFilterListParallel(std::string_view filterListText, unsigned threads,
+                                     const OptimizeOptions &options) {
+     if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+     if (threads == 1) return parseFilterList(filterListText, options);
+ 
+     if (filterListText.starts_with("\xEF\xBB\xBF")) filterListText.remove_prefix(3);
+ 
+     // ~4 Chunks pro Thread für Lastausgleich, aber nicht unter 64 KiB
+     constexpr size_t MIN_CHUNK = 64 * 1024;
+     const size_t target = std::max(MIN_CHUNK, filterListText.size() / (threads * 4) + 1);
+ 
+     std::vector<std::string_view> parts;
+     for (size_t pos = 0; pos < filterListText.size();) {
+         size_t end = std::min(pos + target, filterListText.size());
+         if (end < filterListText.size()) {
+             const char *nl = find_newline(filterListText.data() + end,
+                                           filterListText.data() + filterListText.size());
+             end = static_cast<size_t>(nl - filterListText.data());
+             end = std::min(end + 1, filterListText.size());
          }
+         parts.push_back(filterListText.substr(pos, end - pos));
+         pos = end;
+     }
+ 
+     std::vector<ParsedChunk> chunks(parts.size());
+     parallel_for(parts.size(), threads, [&](size_t i) {
+         chunks[i] = parse_chunk(parts[i], false);
+     });
+ 
+     // Die Regeln verweisen weiter in die Arenen der Chunks.  Ihre Domains
+     // ziehen in eine gemeinsame Tabelle um: die des ersten Chunks, die
+     // übrigen werden der Reihe nach angehängt – die IDs sind dieselben
+     // wie im sequentiellen Pfad.
+     RuleArena            passArena;
+     std::vector<DnrRule> rules;
+     int totalLines = 0, skippedLines = 0;
+     {
+         size_t count = 0;
+         for (const auto &c : chunks) count += c.rules.size();
+         rules.reserve(count);
      }
+     for (auto &c : chunks) {
+         if (&c == &chunks.front()) passArena.domains() = std::move(c.arena->domains());
+         else                       remap_domains(c.rules, c.arena->domains(), passArena);
+         for (auto &r : c.rules) r.id += totalLines;           // Zeilennummer der ganzen Liste
+         rules.insert(rules.end(), c.rules.begin(), c.rules.end());
+         c.rules      = {};
+         totalLines   += c.totalLines;
+         skippedLines += c.skippedLines;
+     }
+ 
+     OptimizeStats opt;
+     optimize_rules(rules, passArena, options, opt);
+     assign_ids(rules, 1);
+     const int processedRules = static_cast<int>(rules.size());
  
-     json out;
-     out["rules"] = std::move(rules);
-     out["stats"] = {{"totalLines", totalLines},
-                     {"processedRules", processedRules},
-                     {"skippedLines", skippedLines}};
+     const size_t per = std::max<size_t>(4096, rules.size() / (threads * 4) + 1);
+     std::vector<std::string> bodies((rules.size() + per - 1) / per);
+     parallel_for(bodies.size(), threads, [&](size_t i) {
+         const size_t begin = i * per, end = std::min(rules.size(), begin + per);
+         append_rules_json(bodies[i], {rules.begin() + begin, rules.begin() + end},
+                           passArena.domains());
+     });
  
-     return out.dump(-1, ' ', false, json::error_handler_t::ignore);
+     std::string body;
+     size_t bodySize = bodies.size();
+     for (const auto &b : bodies) bodySize += b.size();
+     body.reserve(bodySize);
+     for (const auto &b : bodies) {
+         if (b.empty()) continue;
+         if (!body.empty()) body.push_back(',');
+         body += b;
+     }
+     return make_output(body, totalLines, processedRules, skippedLines, opt, options);
  }
  
+ #endif
+ 
  /* ------------------------------------------------------------------ *
   *  EMSCRIPTEN-Binding
   * ------------------------------------------------------------------ */
+ #ifdef __EMSCRIPTEN__
  EMSCRIPTEN_BINDINGS(filter_parser_module) {
      emscripten::function("parseFilterListWasm", &parseFilterListWasm);
+ 
+     emscripten::class_<FilterListParser>("FilterListParser")
+         .constructor<>()
+         .function("feed", &FilterListParser::feed)
+         .function("setMaxRules", &FilterListParser::setMaxRules)
+         .function("finish", &FilterListParser::finish);
  }
+ #endif
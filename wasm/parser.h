@@ -0,0 +1,263 @@
+/***********************************************************************
+ *  Filter-List → Chrome DNR-JSON Parser – öffentliche Schnittstelle
+ *
+ *  Wird vom WASM-Build (Emscripten) und von den nativen Tools unter
+ *  tools/ gemeinsam genutzt.
+ ***********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nlohmann/json_fwd.hpp"
+
+/* ------------------------------------------------------------------ *
+ *  Datenstrukturen
+ * ------------------------------------------------------------------ */
+
+enum class ResourceType : uint8_t {
+    MainFrame, SubFrame, Stylesheet, Script, Image,
+    Font,      Object,   XmlHttpRequest, Ping, CspReport,
+    Media,     WebSocket, WebTransport, WebBundle, Other,
+    Count
+};
+
+// Index = ResourceType = Bit in ResourceTypeMask
+inline constexpr std::array<std::string_view, size_t(ResourceType::Count)> ALL_DNR_RESOURCE_TYPES = {
+    "main_frame",  "sub_frame", "stylesheet",   "script",  "image",
+    "font",        "object",    "xmlhttprequest","ping",    "csp_report",
+    "media",       "websocket", "webtransport", "webbundle","other"};
+
+// Index = Bit in RequestMethodMask; alphabetisch, damit die Bitreihenfolge
+// der sortierten JSON-Ausgabe entspricht
+inline constexpr std::array<std::string_view, 8> SUPPORTED_METHODS = {
+    "CONNECT", "DELETE", "GET", "HEAD",
+    "OPTIONS", "PATCH",  "POST", "PUT"};
+
+using ResourceTypeMask  = uint16_t;
+using RequestMethodMask = uint8_t;
+
+inline constexpr ResourceTypeMask ALL_RESOURCE_TYPES_MASK =
+    (1u << ALL_DNR_RESOURCE_TYPES.size()) - 1;
+
+constexpr ResourceTypeMask resource_type_bit(ResourceType t) {
+    return static_cast<ResourceTypeMask>(1u << static_cast<unsigned>(t));
+}
+
+/* ------------------------------------------------------------------ *
+ *  Speicher
+ *
+ *  Regeln besitzen keine Strings: urlFilter und regexFilter zeigen
+ *  entweder direkt in den Eingabetext oder in die RuleArena des
+ *  Parse-Laufs (synthetisierte Strings wie "||domain/", Domain-Listen).
+ *  Domains tragen die Regeln nur als IDs der DomainTable derselben
+ *  Arena.  Text und Arena müssen leben, solange die Regeln benutzt
+ *  werden; die Arena gibt alles auf einmal frei.
+ * ------------------------------------------------------------------ */
+
+// Dichte Domain-ID: Index in die DomainTable des Parse-Laufs
+using DomainId = uint32_t;
+
+inline constexpr DomainId NO_DOMAIN = UINT32_MAX;
+
+// Interner für Domains.  Jede Domain bekommt beim ersten Auftreten die
+// nächste freie ID; ihr Text liegt genau einmal, in ASCII-Kleinbuchstaben,
+// im zusammenhängenden Pool.  Gleiche ID heißt also gleiche Domain ohne
+// Rücksicht auf Groß-/Kleinschreibung – die Pässe vergleichen nur Zahlen.
+class DomainTable {
+public:
+    DomainId intern(std::string_view domain);
+
+    // Text zu id; gültig bis zum nächsten intern()
+    std::string_view operator[](DomainId id) const {
+        return {pool_.data() + offsets_[id], offsets_[id + 1] - offsets_[id]};
+    }
+
+    size_t size() const { return offsets_.size() - 1; }
+    void   clear();
+
+private:
+    void grow();
+
+    std::string           pool_;
+    std::vector<uint32_t> offsets_{0};  // Anfang je ID, zuletzt das Pool-Ende
+    std::vector<uint64_t> slots_;       // obere 32 Hash-Bits | ID + 1, 0 = frei
+};
+
+class RuleArena {
+public:
+    explicit RuleArena(size_t initialSize = 64 * 1024) : pool_(initialSize) {}
+    RuleArena(const RuleArena &)            = delete;
+    RuleArena &operator=(const RuleArena &) = delete;
+
+    // Uninitialisierter Platz für n Objekte (nur trivial zerstörbare Typen)
+    template <typename T>
+    T *allocate(size_t n) {
+        return static_cast<T *>(pool_.allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Teile hintereinander in die Arena kopieren
+    std::string_view concat(std::initializer_list<std::string_view> parts) {
+        size_t n = 0;
+        for (const auto p : parts) n += p.size();
+        char *dst = allocate<char>(n ? n : 1);
+        char *w   = dst;
+        for (const auto p : parts) {
+            if (!p.empty()) std::memcpy(w, p.data(), p.size());
+            w += p.size();
+        }
+        return {dst, n};
+    }
+
+    std::string_view copy(std::string_view s) { return concat({s}); }
+
+    std::pmr::memory_resource *resource() { return &pool_; }
+
+    // Domains der Regeln in dieser Arena
+    DomainTable       &domains() { return domains_; }
+    const DomainTable &domains() const { return domains_; }
+
+    // Gibt alles frei; vorher erzeugte Regeln werden ungültig
+    void release() {
+        pool_.release();
+        domains_.clear();
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource pool_;
+    DomainTable                         domains_;
+};
+
+// Nicht-leere Liste oder leer = Kondition nicht gesetzt.  IDs aus der
+// DomainTable der Arena, in der die Regel entstanden ist.
+using DomainList = std::span<const DomainId>;
+
+struct DnrRule {
+    int id                       = 0;
+    int priority                 = 1;
+    std::string_view actionType  = "block";
+
+    std::optional<std::string_view> conditionUrlFilter;
+    std::optional<std::string_view> conditionRegexFilter;
+
+    // Bitmasken, erst bei der Serialisierung zu JSON-Arrays; 0 = nicht gesetzt
+    ResourceTypeMask  conditionResourceTypes          = 0;
+    RequestMethodMask conditionRequestMethods         = 0;
+    RequestMethodMask conditionExcludedRequestMethods = 0;
+
+    DomainList conditionRequestDomains;
+    DomainList conditionExcludedRequestDomains;
+    DomainList conditionInitiatorDomains;
+    DomainList conditionExcludedInitiatorDomains;
+};
+
+// Ergebnis eines zeilenbündigen Abschnitts (Regeln noch ohne IDs).
+// Die Regeln verweisen in den geparsten Text und in `arena` (samt deren
+// DomainTable).
+struct ParsedChunk {
+    std::unique_ptr<RuleArena> arena = std::make_unique<RuleArena>();
+    std::vector<DnrRule>       rules;
+    int                        totalLines   = 0;
+    int                        skippedLines = 0;
+};
+
+/* ------------------------------------------------------------------ *
+ *  Bausteine
+ * ------------------------------------------------------------------ */
+
+// Eine Zeile parsen; leer bei Kommentar, Cosmetic-Regel oder Ungültigem.
+// Die Regel verweist in `line` und in `arena`.
+std::optional<DnrRule> parse_line(std::string_view line, int id, RuleArena &arena);
+
+// Optionsteil (hinter '$') auswerten und die Konditionen in rule setzen
+void parse_options(std::string_view options, DnrRule &rule, RuleArena &arena);
+
+// urlFilter in Normalform (siehe parser.cc); verweist in filter oder,
+// wenn umgeschrieben werden musste, in arena
+std::string_view canonical_url_filter(std::string_view filter, RuleArena &arena);
+
+// Regel als JSON-Objekt an out anhängen (ohne DOM, reserviert nichts);
+// domains löst die Domain-IDs der Regel auf
+void write_rule_json(std::string &out, const DnrRule &r, const DomainTable &domains);
+
+// DOM-Variante derselben Serialisierung (Referenz für Benchmarks)
+nlohmann::json rule_to_json(const DnrRule &r, const DomainTable &domains);
+
+/* ------------------------------------------------------------------ *
+ *  Entry-Points
+ * ------------------------------------------------------------------ */
+
+struct DomainWeights;
+struct OptimizeStats;
+
+// Einstellungen der Optimierungs-Pässe (optimize.h)
+struct OptimizeOptions {
+    // Höchstzahl Domains je zusammengefasster requestDomains-Regel
+    // (0 = nackte Domain-Regeln nicht zusammenfassen)
+    size_t maxRequestDomains = 1000;
+    // Von Ausnahmen verdeckte block-Regeln zusätzlich als "shadowReport"
+    // (Zeilennummern) in die Ausgabe schreiben
+    bool reportShadowed = false;
+    // Höchstzahl ausgegebener Regeln (0 = unbegrenzt); bei Überschreitung
+    // Auswahl nach Nutzen, optional gewichtet mit einem Trefferprofil,
+    // und ein "budgetReport" in der Ausgabe
+    size_t               maxRules = 0;
+    const DomainWeights *weights  = nullptr;
+};
+
+// Parst eine komplette Filterliste und liefert
+// {"rules":[...],"stats":{...}} als JSON-String.
+std::string parseFilterList(std::string_view filterListText,
+                            const OptimizeOptions &options = {});
+
+// Entry-Point für JavaScript (embind übergibt den Text per Wert);
+// maxRules wie OptimizeOptions::maxRules (0 = unbegrenzt)
+std::string parseFilterListWasm(std::string filterListText, size_t maxRules);
+
+#ifndef __EMSCRIPTEN__
+// Wie parseFilterList, aber auf `threads` Kerne verteilt (0 = alle).
+// Die Ausgabe ist byte-identisch zum sequentiellen Pfad.
+std::string parseFilterListParallel(std::string_view filterListText,
+                                    unsigned threads = 0,
+                                    const OptimizeOptions &options = {});
+
+// Parst und optimiert wie parseFilterList, liefert aber die Regeln statt
+// JSON (für Werkzeuge, die selbst aufteilen und serialisieren).  Die
+// Regeln verweisen in filterListText und die Arena des Chunks, ihre
+// Domains in chunk.arena->domains(); ihre ID ist noch die Zeilennummer.
+ParsedChunk compileFilterList(std::string_view filterListText, const OptimizeOptions &options,
+                              OptimizeStats &stats);
+#endif
+
+// Inkrementeller Parser für gestreamte Downloads: feed() mit beliebig
+// geschnittenen Stücken, finish() liefert dasselbe JSON wie
+// parseFilterList über den Gesamttext und setzt den Parser zurück.
+// Vollständige Zeilen werden direkt aus dem Stück geparst, nur die
+// urlFilter/regexFilter der Regeln in die Arena kopiert; die
+// angebrochene letzte Zeile wartet in carry_.
+class FilterListParser {
+public:
+    explicit FilterListParser(const OptimizeOptions &options = {}) : options_(options) {}
+
+    void        feed(const std::string &chunk);
+    std::string finish();
+
+    // Regel-Budget für finish() (OptimizeOptions::maxRules, 0 = unbegrenzt)
+    void setMaxRules(size_t maxRules) { options_.maxRules = maxRules; }
+
+private:
+    OptimizeOptions options_;
+    std::string     carry_;
+    ParsedChunk     parsed_;
+    bool            bomChecked_ = false;
+};
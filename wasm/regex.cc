@@ -0,0 +1,676 @@
+/***********************************************************************
+ *  RE2-Syntax für regexFilter (siehe regex.h)
+ *
+ *  Rekursiver Abstieg entlang der RE2-Grammatik:
+ *
+ *    alternation := concat ('|' concat)*
+ *    concat      := (atom quantifier?)*
+ *    atom        := literal | '.' | '^' | '$' | class | escape | group
+ *
+ *  Flags aus (?imsU) gelten bis zum Ende der umgebenden Gruppe.
+ ***********************************************************************/
+
+#include "regex.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t NO_NODE = UINT32_MAX;
+
+struct RegexFlags {
+    bool icase     = false;     // i
+    bool multiline = false;     // m: ^/$ an Zeilengrenzen
+    bool dotNl     = false;     // s: '.' trifft auch '\n'
+    bool ungreedy  = false;     // U: Gier umkehren
+};
+
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+constexpr bool is_word(char c) { return is_alpha(c) || is_digit(c) || c == '_'; }
+
+int hex_value(char c) {
+    if (is_digit(c)) return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void add_range(std::bitset<256> &set, unsigned lo, unsigned hi) {
+    for (unsigned c = lo; c <= hi; ++c) set.set(c);
+}
+
+// Beide Schreibweisen jedes ASCII-Buchstabens in set aufnehmen
+void fold_case(std::bitset<256> &set) {
+    for (unsigned c = 'a'; c <= 'z'; ++c) {
+        if (set.test(c) || set.test(c - 32)) {
+            set.set(c);
+            set.set(c - 32);
+        }
+    }
+}
+
+// \d \s \w bzw. großgeschrieben negiert; false für andere Buchstaben
+bool perl_class(char c, std::bitset<256> &set) {
+    std::bitset<256> s;
+    switch (c | 0x20) {
+    case 'd': add_range(s, '0', '9'); break;
+    case 's': for (const char x : {'\t', '\n', '\f', '\r', ' '}) s.set(static_cast<unsigned char>(x)); break;
+    case 'w': add_range(s, '0', '9'), add_range(s, 'A', 'Z'), add_range(s, 'a', 'z'), s.set('_'); break;
+    default:  return false;
+    }
+    set |= c >= 'a' ? s : ~s;
+    return true;
+}
+
+// [:name:] bzw. [:^name:]
+bool posix_class(std::string_view name, std::bitset<256> &set) {
+    bool negate = false;
+    if (name.starts_with('^')) negate = true, name.remove_prefix(1);
+    std::bitset<256> s;
+    if      (name == "alnum")  add_range(s, '0', '9'), add_range(s, 'A', 'Z'), add_range(s, 'a', 'z');
+    else if (name == "alpha")  add_range(s, 'A', 'Z'), add_range(s, 'a', 'z');
+    else if (name == "ascii")  add_range(s, 0, 0x7F);
+    else if (name == "blank")  s.set(' '), s.set('\t');
+    else if (name == "cntrl")  add_range(s, 0, 0x1F), s.set(0x7F);
+    else if (name == "digit")  add_range(s, '0', '9');
+    else if (name == "graph")  add_range(s, '!', '~');
+    else if (name == "lower")  add_range(s, 'a', 'z');
+    else if (name == "print")  add_range(s, ' ', '~');
+    else if (name == "punct")  add_range(s, '!', '/'), add_range(s, ':', '@'), add_range(s, '[', '`'), add_range(s, '{', '~');
+    else if (name == "space")  add_range(s, '\t', '\r'), s.set(' ');
+    else if (name == "upper")  add_range(s, 'A', 'Z');
+    else if (name == "word")   add_range(s, '0', '9'), add_range(s, 'A', 'Z'), add_range(s, 'a', 'z'), s.set('_');
+    else if (name == "xdigit") add_range(s, '0', '9'), add_range(s, 'A', 'F'), add_range(s, 'a', 'f');
+    else return false;
+    set |= negate ? ~s : s;
+    return true;
+}
+
+// \pX / \p{Name}: Bytes ab 0x80 plus eine ASCII-Näherung der Kategorie
+void unicode_class(std::string_view name, bool negate, std::bitset<256> &set) {
+    if (name.starts_with('^')) negate = !negate, name.remove_prefix(1);
+    std::bitset<256> s;
+    const char cat = name.empty() ? 0 : name.front();
+    if (name == "Any")          add_range(s, 0, 0x7F);
+    else if (cat == 'L')        add_range(s, 'A', 'Z'), add_range(s, 'a', 'z');
+    else if (cat == 'N')        add_range(s, '0', '9');
+    else if (cat == 'P')        posix_class("punct", s);
+    else if (cat == 'Z')        s.set(' ');
+    std::bitset<256> ascii;
+    add_range(ascii, 0, 0x7F);
+    set |= (negate ? ~s & ascii : s) | ~ascii;
+}
+
+class RegexParser {
+public:
+    explicit RegexParser(std::string_view pattern) : p_(pattern) {}
+
+    RegexAst run() {
+        RegexFlags flags;
+        ast_.root = parse_alternation(flags);
+        if (ok() && pos_ < p_.size()) fail(RegexError::Syntax);       // ')' ohne '('
+        if (!ok()) ast_.root = 0;
+        return std::move(ast_);
+    }
+
+private:
+    bool ok() const { return ast_.error == RegexError::None; }
+    bool at_end() const { return pos_ >= p_.size(); }
+    char peek() const { return p_[pos_]; }
+
+    void fail(RegexError e) {
+        if (ok()) {
+            ast_.error    = e;
+            ast_.errorPos = pos_;
+        }
+        pos_ = p_.size();
+    }
+
+    uint32_t add(RegexNode node) {
+        ast_.nodes.push_back(std::move(node));
+        return static_cast<uint32_t>(ast_.nodes.size() - 1);
+    }
+
+    uint32_t add_kind(RegexKind kind) {
+        RegexNode n;
+        n.kind = kind;
+        return add(std::move(n));
+    }
+
+    uint32_t add_literal(char c, const RegexFlags &f) {
+        RegexNode n;
+        n.kind  = RegexKind::Literal;
+        n.ch    = c;
+        n.icase = f.icase && is_alpha(c);
+        return add(std::move(n));
+    }
+
+    uint32_t add_class(std::bitset<256> set, const RegexFlags &f, bool unicode = false) {
+        if (f.icase) fold_case(set);
+        RegexNode n;
+        n.kind    = RegexKind::Class;
+        n.set     = set;
+        n.unicode = unicode;
+        return add(std::move(n));
+    }
+
+    uint32_t add_list(RegexKind kind, std::vector<uint32_t> kids) {
+        if (kids.empty()) return add_kind(RegexKind::Empty);
+        if (kids.size() == 1) return kids.front();
+        RegexNode n;
+        n.kind = kind;
+        n.kids = std::move(kids);
+        return add(std::move(n));
+    }
+
+    // Code Point als Latin-1-Zeichen (wie Chrome: darüber kein Treffer möglich)
+    uint32_t add_code_point(uint32_t cp, const RegexFlags &f) {
+        if (cp > 0xFF) return fail(RegexError::BadEscape), 0;
+        return add_literal(static_cast<char>(cp), f);
+    }
+
+    /* -- Grammatik ----------------------------------------------------- */
+
+    uint32_t parse_alternation(RegexFlags &f) {
+        std::vector<uint32_t> alts{parse_concat(f)};
+        while (ok() && !at_end() && peek() == '|') {
+            ++pos_;
+            alts.push_back(parse_concat(f));
+        }
+        return add_list(RegexKind::Alternate, std::move(alts));
+    }
+
+    uint32_t parse_concat(RegexFlags &f) {
+        std::vector<uint32_t> items;
+        while (ok() && !at_end() && peek() != '|' && peek() != ')') {
+            const uint32_t atom = parse_atom(f);
+            if (atom == NO_NODE) continue;                     // (?flags)
+            items.push_back(parse_quantifier(atom, f));
+        }
+        return add_list(RegexKind::Concat, std::move(items));
+    }
+
+    // {n}, {n,}, {n,m} ab pos; false, wenn dort keine Wiederholung steht
+    // (RE2 liest '{' dann als Literal)
+    bool scan_braces(size_t pos, int &min, int &max, size_t &end) const {
+        auto number = [&](size_t &i, int &out) {
+            const size_t start = i;
+            long         v     = 0;
+            while (i < p_.size() && is_digit(p_[i])) v = std::min(v * 10 + (p_[i++] - '0'), 100000L);
+            out = static_cast<int>(v);
+            return i > start;
+        };
+        size_t i = pos + 1;
+        if (!number(i, min)) return false;
+        max = min;
+        if (i < p_.size() && p_[i] == ',') {
+            ++i;
+            max = -1;
+            if (i < p_.size() && is_digit(p_[i])) number(i, max);
+        }
+        if (i >= p_.size() || p_[i] != '}') return false;
+        end = i + 1;
+        return true;
+    }
+
+    bool at_quantifier() const {
+        if (at_end()) return false;
+        int    lo, hi;
+        size_t end;
+        return peek() == '*' || peek() == '+' || peek() == '?' ||
+               (peek() == '{' && scan_braces(pos_, lo, hi, end));
+    }
+
+    uint32_t parse_quantifier(uint32_t atom, const RegexFlags &f) {
+        if (!at_quantifier()) return atom;
+        int min = 0, max = -1;
+        switch (peek()) {
+        case '*': ++pos_; break;
+        case '+': ++pos_, min = 1; break;
+        case '?': ++pos_, max = 1; break;
+        default: {
+            size_t end = pos_;
+            scan_braces(pos_, min, max, end);
+            if (min > REGEX_MAX_REPEAT || max > REGEX_MAX_REPEAT || (max >= 0 && max < min))
+                return fail(RegexError::BadRepeat), 0;
+            pos_ = end;
+        }
+        }
+        bool greedy = !f.ungreedy;
+        if (!at_end() && peek() == '?') ++pos_, greedy = !greedy;
+        if (at_quantifier()) return fail(RegexError::BadRepeat), 0;   // a**, a*+, a{2}{3}
+
+        RegexNode n;
+        n.kind   = RegexKind::Repeat;
+        n.min    = min;
+        n.max    = max;
+        n.greedy = greedy;
+        n.kids   = {atom};
+        return add(std::move(n));
+    }
+
+    uint32_t parse_atom(RegexFlags &f) {
+        const char c = peek();
+        switch (c) {
+        case '(': return parse_group(f);
+        case '[': return parse_class(f);
+        case '\\': return parse_escape(f);
+        case '*': case '+': case '?':
+            return fail(RegexError::BadRepeat), 0;             // Wiederholung ohne Argument
+        case '.': {
+            ++pos_;
+            RegexNode n;
+            n.kind = RegexKind::AnyChar;
+            n.set.set();
+            if (!f.dotNl) n.set.reset('\n');
+            return add(std::move(n));
+        }
+        case '^':
+            ++pos_;
+            return add_kind(f.multiline ? RegexKind::BeginLine : RegexKind::BeginText);
+        case '$':
+            ++pos_;
+            return add_kind(f.multiline ? RegexKind::EndLine : RegexKind::EndText);
+        case '{':
+            if (at_quantifier()) return fail(RegexError::BadRepeat), 0;
+            [[fallthrough]];
+        default:
+            ++pos_;
+            return add_literal(c, f);
+        }
+    }
+
+    // (?i) ändert f und liefert NO_NODE, sonst einen Group-Knoten
+    uint32_t parse_group(RegexFlags &f) {
+        if (depth_ == REGEX_MAX_DEPTH) return fail(RegexError::TooLarge), 0;
+        ++pos_;                                                 // '('
+        RegexFlags inner   = f;
+        bool       capture = true, named = false;
+        if (!at_end() && peek() == '?') {
+            ++pos_;
+            const std::string_view rest = p_.substr(pos_);
+            if (rest.starts_with('=') || rest.starts_with('!') || rest.starts_with("<=") ||
+                rest.starts_with("<!"))
+                return fail(RegexError::Lookaround), 0;
+            if (rest.starts_with("P<") || rest.starts_with('<')) {    // benannte Gruppe
+                pos_ += rest.starts_with('P') ? 2 : 1;
+                const size_t start = pos_;
+                while (!at_end() && is_word(peek())) ++pos_;
+                if (pos_ == start || at_end() || peek() != '>') return fail(RegexError::Syntax), 0;
+                ++pos_;
+                named = true;
+            } else {
+                capture     = false;
+                bool negate = false, any = false;
+                for (;; ++pos_) {
+                    if (at_end()) return fail(RegexError::Syntax), 0;
+                    const char c = peek();
+                    if (c == ':' || c == ')') break;
+                    if (c == '-' && !negate) {
+                        negate = true;
+                        continue;
+                    }
+                    any = true;
+                    if      (c == 'i') inner.icase     = !negate;
+                    else if (c == 'm') inner.multiline = !negate;
+                    else if (c == 's') inner.dotNl     = !negate;
+                    else if (c == 'U') inner.ungreedy  = !negate;
+                    else return fail(RegexError::Syntax), 0;
+                }
+                if (!any && peek() == ')') return fail(RegexError::Syntax), 0;   // "(?)"
+                if (peek() == ')') {                             // (?flags): gilt für den Rest
+                    ++pos_;
+                    f = inner;
+                    return NO_NODE;
+                }
+                ++pos_;                                          // ':'
+            }
+        }
+        ++depth_;
+        const uint32_t body = parse_alternation(inner);
+        --depth_;
+        if (!ok()) return 0;
+        if (at_end() || peek() != ')') return fail(RegexError::Syntax), 0;
+        ++pos_;
+        RegexNode n;
+        n.kind    = RegexKind::Group;
+        n.capture = capture;
+        n.named   = named;
+        n.kids    = {body};
+        return add(std::move(n));
+    }
+
+    // Einzelzeichen-Escape (auch in Klassen); -1 = kein Einzelzeichen
+    // (Klasse oder Anker), -2 = Fehler gesetzt
+    int parse_char_escape(char c) {
+        switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'a': return '\a';
+        case 'x': {
+            uint32_t v = 0;
+            if (!at_end() && peek() == '{') {
+                ++pos_;
+                const size_t start = pos_;
+                while (!at_end() && hex_value(peek()) >= 0 && v <= 0x10FFFF) v = v * 16 + hex_value(p_[pos_++]);
+                if (pos_ == start || at_end() || peek() != '}' || v > 0x10FFFF)
+                    return fail(RegexError::BadEscape), -2;
+                ++pos_;
+            } else {
+                if (pos_ + 2 > p_.size() || hex_value(p_[pos_]) < 0 || hex_value(p_[pos_ + 1]) < 0)
+                    return fail(RegexError::BadEscape), -2;
+                v = hex_value(p_[pos_]) * 16 + hex_value(p_[pos_ + 1]);
+                pos_ += 2;
+            }
+            return static_cast<int>(v);
+        }
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': {
+            // RE2: \0.. und mehrstellige Oktalzahlen; eine einzelne
+            // Ziffer 1-7 wäre ein Rückverweis
+            if (c != '0' && (at_end() || peek() < '0' || peek() > '7'))
+                return fail(RegexError::Backreference), -2;
+            int v = c - '0';
+            for (int k = 0; k < 2 && !at_end() && peek() >= '0' && peek() <= '7'; ++k) v = v * 8 + (p_[pos_++] - '0');
+            return v;
+        }
+        case '8': case '9':
+            return fail(RegexError::Backreference), -2;
+        default:
+            if (static_cast<unsigned char>(c) < 0x80 && !is_word(c)) return static_cast<unsigned char>(c);
+            return -1;
+        }
+    }
+
+    uint32_t parse_escape(RegexFlags &f) {
+        ++pos_;                                                 // '\\'
+        if (at_end()) return fail(RegexError::BadEscape), 0;
+        const char c = p_[pos_++];
+
+        std::bitset<256> set;
+        if (perl_class(c, set)) return add_class(set, f);
+        switch (c) {
+        case 'b': return add_kind(RegexKind::WordBoundary);
+        case 'B': return add_kind(RegexKind::NotWordBoundary);
+        case 'A': return add_kind(RegexKind::BeginText);
+        case 'z': return add_kind(RegexKind::EndText);
+        case 'C': {
+            RegexNode n;
+            n.kind = RegexKind::AnyChar;
+            n.set.set();
+            return add(std::move(n));
+        }
+        case 'p': case 'P': {
+            std::string_view name;
+            if (!parse_unicode_name(name)) return 0;
+            unicode_class(name, c == 'P', set);
+            return add_class(set, f, true);
+        }
+        case 'Q': {                                             // \Q...\E wörtlich
+            const size_t end = p_.find("\\E", pos_);
+            const size_t stop = end == std::string_view::npos ? p_.size() : end;
+            std::vector<uint32_t> lits;
+            for (; pos_ < stop; ++pos_) lits.push_back(add_literal(p_[pos_], f));
+            if (end != std::string_view::npos) pos_ += 2;
+            return add_list(RegexKind::Concat, std::move(lits));
+        }
+        default: break;
+        }
+        const int v = parse_char_escape(c);
+        if (v == -2) return 0;
+        if (v == -1) return fail(RegexError::BadEscape), 0;
+        return add_code_point(static_cast<uint32_t>(v), f);
+    }
+
+    bool parse_unicode_name(std::string_view &name) {
+        if (at_end()) return fail(RegexError::BadEscape), false;
+        if (peek() != '{') {
+            name = p_.substr(pos_++, 1);
+            return true;
+        }
+        const size_t close = p_.find('}', pos_);
+        if (close == std::string_view::npos || close == pos_ + 1) return fail(RegexError::BadEscape), false;
+        name = p_.substr(pos_ + 1, close - pos_ - 1);
+        pos_ = close + 1;
+        return true;
+    }
+
+    // Einzelzeichen in einer Klasse (Literal oder Escape); -1 = Klasse
+    // in set ergänzt, -2 = Fehler
+    int parse_class_char(std::bitset<256> &set) {
+        const char c = p_[pos_++];
+        if (c != '\\') return static_cast<unsigned char>(c);
+        if (at_end()) return fail(RegexError::Syntax), -2;
+        const char e = p_[pos_++];
+        if (perl_class(e, set)) return -1;
+        if (e == 'p' || e == 'P') {
+            std::string_view name;
+            if (!parse_unicode_name(name)) return -2;
+            unicode_class(name, e == 'P', set);
+            unicodeInClass_ = true;
+            return -1;
+        }
+        const int v = parse_char_escape(e);
+        if (v == -2) return -2;
+        if (v == -1 || v > 0xFF) return fail(RegexError::BadEscape), -2;
+        return v;
+    }
+
+    uint32_t parse_class(const RegexFlags &f) {
+        ++pos_;                                                 // '['
+        bool negate = false;
+        if (!at_end() && peek() == '^') negate = true, ++pos_;
+        std::bitset<256> set;
+        unicodeInClass_ = false;
+        for (bool first = true;; first = false) {
+            if (at_end()) return fail(RegexError::Syntax), 0;
+            if (peek() == ']' && !first) {
+                ++pos_;
+                break;
+            }
+            if (p_.substr(pos_).starts_with("[:")) {
+                const size_t close = p_.find(":]", pos_ + 2);
+                if (close == std::string_view::npos ||
+                    !posix_class(p_.substr(pos_ + 2, close - pos_ - 2), set))
+                    return fail(RegexError::Syntax), 0;
+                pos_ = close + 2;
+                continue;
+            }
+            const int lo = parse_class_char(set);
+            if (lo == -2) return 0;
+            if (lo == -1) continue;
+            if (pos_ + 1 < p_.size() && peek() == '-' && p_[pos_ + 1] != ']') {
+                ++pos_;
+                const int hi = parse_class_char(set);
+                if (hi == -2) return 0;
+                if (hi < lo) return fail(RegexError::Syntax), 0;   // auch [a-\d]
+                add_range(set, static_cast<unsigned>(lo), static_cast<unsigned>(hi));
+            } else {
+                set.set(static_cast<unsigned>(lo));
+            }
+        }
+        if (f.icase) fold_case(set);
+        if (negate) set.flip();
+        return add_class(set, RegexFlags{}, unicodeInClass_);
+    }
+
+    std::string_view p_;
+    size_t           pos_ = 0;
+    RegexAst         ast_;
+    int              depth_          = 0;
+    bool             unicodeInClass_ = false;
+};
+
+}  // namespace
+
+RegexAst parse_regex(std::string_view pattern) {
+    return RegexParser(pattern).run();
+}
+
+std::string_view regex_error_name(RegexError e) {
+    switch (e) {
+    case RegexError::None:          return "none";
+    case RegexError::Syntax:        return "syntax";
+    case RegexError::Lookaround:    return "lookaround";
+    case RegexError::Backreference: return "backreference";
+    case RegexError::BadEscape:     return "bad escape";
+    case RegexError::BadRepeat:     return "bad repetition";
+    case RegexError::NonAscii:      return "non-ascii";
+    case RegexError::TooLarge:      return "too large";
+    }
+    return "unknown";
+}
+
+/* ------------------------------------------------------------------ *
+ *  Programmgröße
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+// Sättigt, damit verschachtelte Wiederholungen nicht überlaufen
+constexpr size_t SIZE_CAP = size_t(1) << 30;
+
+size_t sat_add(size_t a, size_t b) { return std::min(a + b, SIZE_CAP); }
+size_t sat_mul(size_t a, size_t b) { return b && a > SIZE_CAP / b ? SIZE_CAP : a * b; }
+
+// Bytebereiche einer Klasse, wie RE2 sie kompiliert: case-insensitiv
+// gefaltet (ASCII und Latin-1); Bereiche ganz in A-Z entfallen, weil
+// RE2 dann die Kleinbuchstaben-Bereiche mit Fold-Flag ausgibt
+size_t class_ranges(std::bitset<256> set) {
+    fold_case(set);
+    for (unsigned c = 0xC0; c <= 0xDE; ++c) {
+        if (c == 0xD7) continue;                                // '×' ↔ '÷' sind keine Paare
+        if (set.test(c) || set.test(c + 32)) set.set(c), set.set(c + 32);
+    }
+    size_t runs = 0;
+    for (unsigned c = 0; c < 256;) {
+        if (!set.test(c)) {
+            ++c;
+            continue;
+        }
+        const unsigned lo = c;
+        while (c < 256 && set.test(c)) ++c;
+        if (lo < 'A' || c - 1 > 'Z') ++runs;
+    }
+    return runs;
+}
+
+// n Bereiche kosten n ByteRange- und n-1 Alt-Instruktionen; \p-Klassen
+// zerfallen in Latin-1 in mehr Bereiche, als die ASCII-Näherung zeigt
+size_t class_size(const RegexNode &n) {
+    const size_t runs = class_ranges(n.set);
+    return (runs ? 2 * runs - 1 : 1) + (n.unicode ? 12 : 0);
+}
+
+// '.' bleibt außen vor: \C legt RE2 nicht mit Klassen zusammen
+bool single_char(const RegexNode &n) {
+    return n.kind == RegexKind::Literal || n.kind == RegexKind::Class;
+}
+
+std::bitset<256> char_set(const RegexNode &n) {
+    if (n.kind != RegexKind::Literal) return n.set;
+    std::bitset<256> s;
+    s.set(static_cast<unsigned char>(n.ch));
+    return s;
+}
+
+// Trifft der Knoten auch den leeren String?
+bool nullable(const RegexAst &ast, uint32_t id) {
+    const RegexNode &n = ast[id];
+    switch (n.kind) {
+    case RegexKind::Literal: case RegexKind::AnyChar: case RegexKind::Class:
+        return false;
+    case RegexKind::Group:
+        return nullable(ast, n.kids[0]);
+    case RegexKind::Concat:
+        return std::all_of(n.kids.begin(), n.kids.end(), [&](uint32_t k) { return nullable(ast, k); });
+    case RegexKind::Alternate:
+        return std::any_of(n.kids.begin(), n.kids.end(), [&](uint32_t k) { return nullable(ast, k); });
+    case RegexKind::Repeat:
+        return n.min == 0 || nullable(ast, n.kids[0]);
+    default:
+        return true;                                            // leer, Anker, \b
+    }
+}
+
+size_t node_size(const RegexAst &ast, uint32_t id) {
+    const RegexNode &n = ast[id];
+    switch (n.kind) {
+    case RegexKind::Empty:
+        return 1;                                               // Nop
+    case RegexKind::Literal:
+        return static_cast<unsigned char>(n.ch) < 0x80 ? 1 : 3;
+    case RegexKind::AnyChar:
+    case RegexKind::Class:
+        return class_size(n);
+    case RegexKind::BeginText: case RegexKind::EndText:
+    case RegexKind::BeginLine: case RegexKind::EndLine:
+    case RegexKind::WordBoundary: case RegexKind::NotWordBoundary:
+        return 1;
+    case RegexKind::Group:
+        // Chrome setzt never_capture, RE2 behält aber benannte Gruppen
+        return sat_add(node_size(ast, n.kids[0]), n.named ? 2 : 0);
+    case RegexKind::Concat: {
+        size_t total = 0;
+        for (const uint32_t k : n.kids) total = sat_add(total, node_size(ast, k));
+        return total;
+    }
+    case RegexKind::Alternate: {
+        // Einzelzeichen-Alternativen legt RE2 zu einer Klasse zusammen
+        if (std::all_of(n.kids.begin(), n.kids.end(), [&](uint32_t k) { return single_char(ast[k]); })) {
+            RegexNode merged;
+            merged.kind = RegexKind::Class;
+            for (const uint32_t k : n.kids) {
+                merged.set |= char_set(ast[k]);
+                merged.unicode |= ast[k].unicode;
+            }
+            return class_size(merged);
+        }
+        size_t total = n.kids.size() - 1;                       // Alt
+        for (const uint32_t k : n.kids) total = sat_add(total, node_size(ast, k));
+        return total;
+    }
+    case RegexKind::Repeat: {
+        const size_t body = node_size(ast, n.kids[0]);
+        if (n.max == 0) return 1;                               // x{0}: Nop
+        const size_t min = static_cast<size_t>(n.min);
+        if (n.max < 0 && min == 0)                              // x*, bei leerem x mit Nop
+            return sat_add(body, nullable(ast, n.kids[0]) ? 2 : 1);
+        if (n.max < 0) return sat_add(sat_mul(body, min), 1);
+        const size_t optional = static_cast<size_t>(n.max) - min;
+        return sat_add(sat_mul(body, min), sat_mul(sat_add(body, 1), optional));
+    }
+    }
+    return SIZE_CAP;
+}
+
+// Beginnt das Muster mit ^, braucht RE2 keine vorangestellte .*?-Schleife
+bool anchored_start(const RegexAst &ast, uint32_t id) {
+    const RegexNode &n = ast[id];
+    if (n.kind == RegexKind::BeginText) return true;
+    if (n.kind == RegexKind::Group) return anchored_start(ast, n.kids[0]);
+    if (n.kind == RegexKind::Concat) return anchored_start(ast, n.kids[0]);
+    return false;
+}
+
+}  // namespace
+
+size_t regex_program_size(const RegexAst &ast) {
+    // Fail und Match, ohne führendes ^ zusätzlich die .*?-Schleife
+    const size_t body = node_size(ast, ast.root);
+    return anchored_start(ast, ast.root) ? sat_add(body, 2) : sat_add(body, 4);
+}
+
+RegexError check_regex_filter(std::string_view pattern) {
+    if (pattern.empty()) return RegexError::Syntax;
+    for (const char c : pattern)
+        if (static_cast<unsigned char>(c) >= 0x80) return RegexError::NonAscii;
+    const RegexAst ast = parse_regex(pattern);
+    if (ast.error != RegexError::None) return ast.error;
+    if (regex_program_size(ast) > REGEX_MAX_PROGRAM_SIZE) return RegexError::TooLarge;
+    return RegexError::None;
+}
@@ -0,0 +1,105 @@
+/***********************************************************************
+ *  RE2-Syntax für regexFilter
+ *
+ *  Chrome wertet regexFilter mit RE2 aus.  parse_regex liest die
+ *  RE2-Syntax in einen kleinen Syntaxbaum, den die Optimierungs-Pässe
+ *  analysieren (etwa um einfache Regexe in urlFilter umzuschreiben).
+ *  Was RE2 ablehnt (Lookarounds, Rückverweise, ...), liefert einen
+ *  Fehler samt Position.
+ *
+ *  Gearbeitet wird wie in Chrome auf Latin-1: ein Zeichen ist ein Byte,
+ *  \x{..} über 0xFF ist ein Fehler.  URLs sind nach Chromes
+ *  Kanonisierung ohnehin ASCII.
+ ***********************************************************************/
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class RegexKind : uint8_t {
+    Empty,              // leerer Ausdruck
+    Literal,            // ch (icase: beide Schreibweisen)
+    AnyChar,            // '.', set = getroffene Bytes
+    Class,              // [...], \d, \w, ...; set = getroffene Bytes
+    BeginText,          // ^ bzw. \A
+    EndText,            // $ bzw. \z
+    BeginLine,          // ^ unter (?m)
+    EndLine,            // $ unter (?m)
+    WordBoundary,       // \b
+    NotWordBoundary,    // \B
+    Concat,             // kids nacheinander
+    Alternate,          // kids als Alternativen
+    Repeat,             // kids[0] min..max Mal (max < 0 = unbegrenzt)
+    Group,              // kids[0] in Klammern (capture: merkt sich den Treffer)
+};
+
+struct RegexNode {
+    RegexKind             kind    = RegexKind::Empty;
+    char                  ch      = 0;
+    bool                  icase   = false;
+    bool                  greedy  = true;
+    bool                  capture = false;
+    bool                  named   = false;  // (?P<name>..) bzw. (?<name>..)
+    bool                  unicode = false;  // \p{..}/\P{..}: set nur ASCII-Näherung
+    int                   min     = 0;
+    int                   max     = 0;
+    std::bitset<256>      set;
+    std::vector<uint32_t> kids;
+};
+
+enum class RegexError : uint8_t {
+    None,
+    Syntax,             // unvollständig, unbalanciert, ungültige Klasse
+    Lookaround,         // (?=  (?!  (?<=  (?<!
+    Backreference,      // \1 ... \9
+    BadEscape,          // \Z, unbekannte Buchstaben-Escapes
+    BadRepeat,          // a**, a*+, {n,m} über 1000
+    NonAscii,           // Chrome verlangt ASCII im regexFilter
+    TooLarge,           // RE2-Programm über Chromes Speichergrenze, zu tief verschachtelt
+};
+
+struct RegexAst {
+    std::vector<RegexNode> nodes;
+    uint32_t               root     = 0;
+    RegexError             error    = RegexError::None;
+    size_t                 errorPos = 0;
+
+    const RegexNode &operator[](uint32_t n) const { return nodes[n]; }
+};
+
+// RE2 begrenzt Wiederholungszähler
+inline constexpr int REGEX_MAX_REPEAT = 1000;
+
+// Klammertiefe; RE2 erlaubt 1000, der rekursive Abstieg hier aber nur,
+// was der WASM-Stack sicher trägt
+inline constexpr int REGEX_MAX_DEPTH = 100;
+
+RegexAst         parse_regex(std::string_view pattern);
+std::string_view regex_error_name(RegexError e);
+
+/* ------------------------------------------------------------------ *
+ *  Chromes Prüfung beim Hinzufügen
+ *
+ *  Chrome kompiliert regexFilter mit RE2 (Latin-1, case-insensitiv,
+ *  ohne Captures, max_mem 2 KiB).  Zwei Drittel davon stehen dem
+ *  Programm zu; mehr Instruktionen lehnt RE2 als "pattern too large"
+ *  ab und updateDynamicRules den ganzen Aufruf.  regex_program_size
+ *  schätzt die Instruktionen, wie der RE2-Compiler sie vor dem Flatten
+ *  zählt (Klassen: Bereiche nach Case-Folding, Wiederholungen
+ *  ausgerollt, {n,m} als n Kopien plus m-n optionale).  Abweichungen
+ *  gehen nur nach oben (etwa wenn RE2 gemeinsame Präfixe von
+ *  Alternativen zusammenlegt) – was die Schätzung durchlässt, nimmt
+ *  Chrome an.
+ * ------------------------------------------------------------------ */
+
+// Höchste Programmgröße unter Chromes Optionen (gemessen an RE2)
+inline constexpr size_t REGEX_MAX_PROGRAM_SIZE = 116;
+
+size_t regex_program_size(const RegexAst &ast);
+
+// None, wenn Chrome den regexFilter annimmt, sonst der Grund
+RegexError check_regex_filter(std::string_view pattern);
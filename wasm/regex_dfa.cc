@@ -0,0 +1,696 @@
+/***********************************************************************
+ *  Lazy-DFA für regexFilter (siehe regex_dfa.h)
+ ***********************************************************************/
+
+#include "regex_dfa.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstring>
+#include <span>
+#include <unordered_set>
+#include <utility>
+
+#include "regex.h"
+
+/* ------------------------------------------------------------------ *
+ *  Hilfs-Utilities
+ * ------------------------------------------------------------------ */
+
+namespace {
+
+constexpr uint32_t NONE        = UINT32_MAX;
+constexpr size_t   MAX_INSTS   = 20000;         // je Muster, {n,m} ausgerollt
+constexpr size_t   MIN_LITERAL = 3;             // kürzere Literale filtern kaum
+constexpr size_t   MAX_LITERAL = 64;
+
+constexpr char ascii_lower(char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; }
+
+constexpr bool is_word(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Ergänzt ASCII-Buchstaben um die andere Schreibweise (wie in regex.cc)
+std::bitset<256> fold_case(std::bitset<256> set) {
+    for (unsigned c = 'a'; c <= 'z'; ++c) {
+        if (set.test(c) || set.test(c - 32)) {
+            set.set(c);
+            set.set(c - 32);
+        }
+    }
+    return set;
+}
+
+// Erste drei Zeichen (klein) als Schlüssel des Vorfilters
+uint32_t trigram(const char *p) {
+    return uint32_t(uint8_t(ascii_lower(p[0]))) << 16 | uint32_t(uint8_t(ascii_lower(p[1]))) << 8 |
+           uint8_t(ascii_lower(p[2]));
+}
+
+constexpr size_t TRIGRAM_BITS = size_t(1) << 16;
+constexpr size_t trigram_bit(uint32_t t) { return (t * 0x9E3779B1u) >> 16; }
+
+/* ------------------------------------------------------------------ *
+ *  Literal-Vorfilter
+ *
+ *  Sucht im Syntaxbaum ein Literal, das jeder Treffer enthalten muss:
+ *  Verkettungen fügen benachbarte feste Stücke zusammen (Zusicherungen
+ *  sind breitenlos und unterbrechen nicht), Wiederholungen mit min ≥ 1
+ *  erben das Literal ihres Kindes, Alternativen und alles Optionale
+ *  liefern keins.
+ * ------------------------------------------------------------------ */
+
+struct Required {
+    bool        exact = false;  // Teilbaum trifft genau text
+    std::string text;           // klein geschrieben
+    std::string best;           // längstes Literal, das jeder Treffer enthält
+};
+
+const std::string &longer(const std::string &a, const std::string &b) { return b.size() > a.size() ? b : a; }
+
+// Einzelnes Zeichen (bis auf Schreibweise) oder 0
+char single_char(const std::bitset<256> &set) {
+    const std::bitset<256> folded = fold_case(set);
+    const size_t           count  = folded.count();
+    unsigned               c      = 0;
+    while (c < 256 && !folded.test(c)) ++c;
+    if (count == 1) return char(c);
+    return count == 2 && c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : 0;   // Buchstabe in beiden Schreibweisen
+}
+
+Required required(const RegexAst &ast, uint32_t n) {
+    const RegexNode &node = ast[n];
+    Required         r;
+    switch (node.kind) {
+    case RegexKind::Empty:
+    case RegexKind::BeginText:
+    case RegexKind::EndText:
+    case RegexKind::BeginLine:
+    case RegexKind::EndLine:
+    case RegexKind::WordBoundary:
+    case RegexKind::NotWordBoundary:
+        r.exact = true;
+        break;
+    case RegexKind::Literal:
+        r.exact = true;
+        r.text  = std::string(1, ascii_lower(node.ch));
+        break;
+    case RegexKind::AnyChar:
+    case RegexKind::Class:
+        if (const char c = single_char(node.set)) {
+            r.exact = true;
+            r.text  = std::string(1, c);
+        }
+        break;
+    case RegexKind::Group:
+        return required(ast, node.kids[0]);
+    case RegexKind::Concat: {
+        std::string run;                        // laufendes festes Stück
+        r.exact = true;
+        for (const uint32_t k : node.kids) {
+            Required kid = required(ast, k);
+            if (kid.exact) {
+                run += kid.text;
+                continue;
+            }
+            r.exact = false;
+            r.best  = longer(longer(r.best, run), kid.best);
+            run.clear();
+        }
+        if (r.exact) r.text = std::move(run);
+        else         r.best = longer(r.best, run);
+        break;
+    }
+    case RegexKind::Alternate:
+        break;
+    case RegexKind::Repeat: {
+        if (node.min == 0) break;
+        Required kid = required(ast, node.kids[0]);
+        if (!kid.exact) return Required{false, {}, std::move(kid.best)};
+        std::string copies;                     // min Kopien hintereinander stehen sicher da
+        for (int i = 0; i < node.min && copies.size() < MAX_LITERAL; ++i) copies += kid.text;
+        r.exact = node.min == node.max && copies.size() == kid.text.size() * size_t(node.min);
+        (r.exact ? r.text : r.best) = std::move(copies);
+        break;
+    }
+    }
+    if (r.exact) r.best = r.text;
+    if (r.best.size() > MAX_LITERAL) r.best.resize(MAX_LITERAL);
+    return r;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Thompson-NFA
+ * ------------------------------------------------------------------ */
+
+enum class Op : uint8_t {
+    Byte,               // ein Byte aus set, weiter bei out
+    Split,              // out und out1
+    Nop,                // weiter bei out
+    Assert,             // weiter bei out, wenn assertion gilt
+    Match,              // Muster out trifft
+};
+
+struct Inst {
+    Op               op        = Op::Nop;
+    RegexKind        assertion = RegexKind::Empty;
+    uint32_t         out = NONE, out1 = NONE;
+    std::bitset<256> set;
+};
+
+// Teilprogramm: Startinstruktion und offene Ausgänge (Instruktion * 2,
+// + 1 für out1), die der Aufrufer mit dem Nachfolger verbindet
+struct Frag {
+    uint32_t              start = NONE;
+    std::vector<uint32_t> holes;
+};
+
+class Compiler {
+public:
+    Compiler(const RegexAst &ast, std::vector<Inst> &insts) : ast_(ast), insts_(insts), base_(insts.size()) {}
+
+    // Startinstruktion des Musters oder NONE, wenn es zu groß wird
+    uint32_t run(uint32_t pattern) {
+        const Frag f = compile(ast_.root);
+        if (too_large()) return NONE;
+        const uint32_t match = emit(Op::Match);
+        insts_[match].out    = pattern;
+        patch(f.holes, match);
+        return f.start;
+    }
+
+    bool assertions() const { return assertions_; }
+
+private:
+    bool too_large() const { return insts_.size() - base_ > MAX_INSTS; }
+
+    uint32_t emit(Op op) {
+        insts_.emplace_back().op = op;
+        return static_cast<uint32_t>(insts_.size() - 1);
+    }
+
+    void patch(const std::vector<uint32_t> &holes, uint32_t target) {
+        for (const uint32_t h : holes) (h & 1 ? insts_[h >> 1].out1 : insts_[h >> 1].out) = target;
+    }
+
+    Frag single(Op op) {
+        const uint32_t pc = emit(op);
+        return {pc, {pc * 2}};
+    }
+
+    Frag byte_set(const std::bitset<256> &set) {
+        Frag f              = single(Op::Byte);
+        insts_[f.start].set = set;
+        return f;
+    }
+
+    // g hinter f hängen (f.start == NONE: f ist noch leer)
+    void chain(Frag &f, Frag g) {
+        if (f.start == NONE) {
+            f = std::move(g);
+            return;
+        }
+        patch(f.holes, g.start);
+        f.holes = std::move(g.holes);
+    }
+
+    Frag compile(uint32_t n) {
+        if (too_large()) return single(Op::Nop);
+        const RegexNode &node = ast_[n];
+        switch (node.kind) {
+        case RegexKind::Empty:
+            return single(Op::Nop);
+        case RegexKind::Literal: {
+            std::bitset<256> set;
+            set.set(static_cast<unsigned char>(node.ch));
+            return byte_set(node.icase ? fold_case(set) : set);
+        }
+        case RegexKind::AnyChar:
+        case RegexKind::Class:
+            return byte_set(node.set);
+        case RegexKind::BeginText:
+        case RegexKind::EndText:
+        case RegexKind::BeginLine:
+        case RegexKind::EndLine:
+        case RegexKind::WordBoundary:
+        case RegexKind::NotWordBoundary: {
+            Frag f                    = single(Op::Assert);
+            insts_[f.start].assertion = node.kind;
+            assertions_               = true;
+            return f;
+        }
+        case RegexKind::Group:
+            return compile(node.kids[0]);
+        case RegexKind::Concat: {
+            Frag f;
+            for (const uint32_t k : node.kids) chain(f, compile(k));
+            return f.start == NONE ? single(Op::Nop) : f;
+        }
+        case RegexKind::Alternate: {
+            Frag f = compile(node.kids.back());
+            for (size_t i = node.kids.size() - 1; i-- > 0;) {
+                Frag           alt   = compile(node.kids[i]);
+                const uint32_t split = emit(Op::Split);
+                insts_[split].out    = alt.start;
+                insts_[split].out1   = f.start;
+                f.start              = split;
+                f.holes.insert(f.holes.end(), alt.holes.begin(), alt.holes.end());
+            }
+            return f;
+        }
+        case RegexKind::Repeat:
+            return repeat(node);
+        }
+        return single(Op::Nop);
+    }
+
+    // x{min,max}: min Kopien, dann x* bzw. max - min geschachtelte
+    // optionale Kopien (x(x(x)?)?)?
+    Frag repeat(const RegexNode &node) {
+        Frag f;
+        for (int i = 0; i < node.min; ++i) chain(f, compile(node.kids[0]));
+        if (node.max < 0) {
+            const uint32_t split = emit(Op::Split);
+            const Frag     x     = compile(node.kids[0]);
+            insts_[split].out    = x.start;
+            patch(x.holes, split);
+            chain(f, Frag{split, {split * 2 + 1}});
+        } else {
+            std::vector<uint32_t> skips;
+            for (int i = node.min; i < node.max; ++i) {
+                const uint32_t split = emit(Op::Split);
+                Frag           x     = compile(node.kids[0]);
+                insts_[split].out    = x.start;
+                skips.push_back(split * 2 + 1);
+                chain(f, Frag{split, std::move(x.holes)});
+            }
+            f.holes.insert(f.holes.end(), skips.begin(), skips.end());
+        }
+        return f.start == NONE ? single(Op::Nop) : f;
+    }
+
+    const RegexAst    &ast_;
+    std::vector<Inst> &insts_;
+    size_t             base_;
+    bool               assertions_ = false;
+};
+
+}  // namespace
+
+struct RegexSet::Program {
+    std::vector<Inst>     insts;
+    std::vector<uint32_t> starts;               // je Muster die erste Instruktion
+    bool                  assertions = false;
+};
+
+/* ------------------------------------------------------------------ *
+ *  Lazy-DFA
+ *
+ *  Ein Zustand ist die Menge der NFA-Instruktionen (Byte, Assert,
+ *  Match), die nach dem bisherigen Text offen sind, dazu was über das
+ *  letzte Byte bekannt ist (Textanfang, Wortzeichen, '\n') und welche
+ *  Muster unmittelbar davor getroffen haben.  Zusicherungen werden erst
+ *  beim Übergang ausgewertet, wenn auch das nächste Byte feststeht.
+ *  Da irgendwo im Text gesucht wird, kommen die Startinstruktionen
+ *  aller Muster in jeden Zustand.
+ *
+ *  Übergänge gehen auf Byte-Klassen: Bytes, die keine Byte-Menge des
+ *  Programms (und keine Zusicherung) unterscheidet, teilen sich eine
+ *  Spalte der Tabelle.
+ * ------------------------------------------------------------------ */
+
+struct RegexSet::Dfa {
+    static constexpr uint32_t UNKNOWN = UINT32_MAX;
+    static constexpr uint32_t MATCH   = 0x80000000u;    // Zielzustand meldet Treffer
+
+    enum : uint8_t { AT_START = 1, AFTER_WORD = 2, AFTER_NEWLINE = 4 };
+
+    struct State {
+        const std::string *key      = nullptr;  // Schlüssel in ids_: Flags, Treffer, Instruktionen
+        uint32_t           endBegin = NONE;     // Treffer am Textende in endPool_
+        uint32_t           endCount = 0;
+        uint32_t           reported = 0;        // Suche, in der die Treffer schon gemeldet sind
+    };
+
+    Dfa(const Program &program, size_t budget, size_t &resets)
+        : program_(program), budget_(budget), resets_(resets), mark_(program.insts.size(), 0) {
+        std::unordered_set<std::bitset<256>> sets;
+        for (const Inst &in : program.insts) {
+            if (in.op == Op::Byte) sets.insert(in.set);
+        }
+        if (program.assertions) {
+            std::bitset<256> word, newline;
+            for (unsigned c = 0; c < 256; ++c) word[c] = is_word(static_cast<unsigned char>(c));
+            newline.set('\n');
+            sets.insert(word);
+            sets.insert(newline);
+        }
+        // Partition verfeinern: je Menge zerfällt jede Klasse in drinnen/draußen
+        classOf_.fill(0);
+        classes_ = 1;
+        for (const std::bitset<256> &set : sets) {
+            std::array<uint32_t, 512> renumber;
+            renumber.fill(NONE);
+            uint32_t next = 0;
+            for (unsigned c = 0; c < 256; ++c) {
+                uint32_t &id = renumber[classOf_[c] * 2 + set.test(c)];
+                if (id == NONE) id = next++;
+                classOf_[c] = static_cast<uint8_t>(id);
+            }
+            classes_ = next;
+        }
+    }
+
+    size_t states() const { return states_.size(); }
+
+    // Trägt in hits alle Muster ein, die irgendwo in text treffen
+    void search(std::string_view text, std::vector<uint64_t> &hits) {
+        if (start_ == NONE) start_ = start_state();
+        if (++search_ == 0) {
+            for (State &st : states_) st.reported = 0;
+            search_ = 1;
+        }
+        uint32_t s = start_;
+        for (const char ch : text) {
+            const auto c = static_cast<unsigned char>(ch);
+            uint32_t   t = trans_[size_t(s) * classes_ + classOf_[c]];
+            if (t == UNKNOWN) t = step(s, c);
+            s = t & ~MATCH;
+            if ((t & MATCH) && states_[s].reported != search_) {
+                states_[s].reported = search_;
+                report(*states_[s].key, hits);
+            }
+        }
+        for (const uint32_t p : end_matches(s)) hits[p / 64] |= uint64_t(1) << (p % 64);
+    }
+
+private:
+    /* -- Schlüssel: [Flags][Zahl der Treffer][Treffer...][Instruktionen...] -- */
+
+    static std::string make_key(uint8_t flags, const std::vector<uint32_t> &matches,
+                                const std::vector<uint32_t> &insts) {
+        std::string key(1 + 4 * (1 + matches.size() + insts.size()), '\0');
+        const auto  count = static_cast<uint32_t>(matches.size());
+        key[0]            = static_cast<char>(flags);
+        std::memcpy(&key[1], &count, 4);
+        if (count) std::memcpy(&key[5], matches.data(), 4 * matches.size());
+        if (!insts.empty()) std::memcpy(&key[5 + 4 * matches.size()], insts.data(), 4 * insts.size());
+        return key;
+    }
+
+    static uint32_t key_word(const std::string &key, size_t i) {
+        uint32_t w;
+        std::memcpy(&w, key.data() + 1 + 4 * i, 4);
+        return w;
+    }
+
+    static void report(const std::string &key, std::vector<uint64_t> &hits) {
+        const uint32_t count = key_word(key, 0);
+        for (uint32_t i = 1; i <= count; ++i) {
+            const uint32_t p = key_word(key, i);
+            hits[p / 64] |= uint64_t(1) << (p % 64);
+        }
+    }
+
+    /* -- Zustände ------------------------------------------------------ */
+
+    uint32_t start_state() {
+        closure(program_.starts);
+        return intern(make_key(AT_START, {}, list_), true);
+    }
+
+    // ID des Zustands; NONE, wenn er nicht mehr ins Budget passt (außer force)
+    uint32_t intern(std::string key, bool force) {
+        if (const auto it = ids_.find(key); it != ids_.end()) return it->second;
+        const size_t cost = sizeof(State) + 4 * classes_ + 2 * key.size() + 64;
+        if (used_ + cost > budget_ && !force) return NONE;
+        used_ += cost;
+        const auto id = static_cast<uint32_t>(states_.size());
+        const auto it = ids_.emplace(std::move(key), id).first;
+        states_.push_back(State{&it->first});
+        trans_.resize(trans_.size() + classes_, UNKNOWN);
+        return id;
+    }
+
+    void reset() {
+        states_.clear();
+        trans_.clear();
+        ids_.clear();
+        endPool_.clear();
+        used_  = 0;
+        start_ = NONE;
+        ++resets_;
+    }
+
+    // Übergang von s mit Byte c berechnen und eintragen
+    uint32_t step(uint32_t s, unsigned char c) {
+        const std::string from  = *states_[s].key;      // überlebt ein reset()
+        const auto        flags = static_cast<uint8_t>(from[0]);
+        expand(from, flags, c, false);
+        std::vector<uint32_t> matches = std::move(found_);
+        std::sort(matches.begin(), matches.end());
+        stepped_.insert(stepped_.end(), program_.starts.begin(), program_.starts.end());
+        closure(stepped_);
+
+        const uint8_t next = (is_word(c) ? AFTER_WORD : 0) | (c == '\n' ? AFTER_NEWLINE : 0);
+        std::string   key  = make_key(next, matches, list_);
+        uint32_t      t    = intern(key, false);
+        if (t == NONE) {
+            reset();
+            s = intern(from, true);
+            t = intern(std::move(key), true);
+        }
+        if (!matches.empty()) t |= MATCH;
+        trans_[size_t(s) * classes_ + classOf_[c]] = t;
+        return t;
+    }
+
+    std::span<const uint32_t> end_matches(uint32_t s) {
+        State &st = states_[s];
+        if (st.endBegin == NONE) {
+            const std::string &key = *st.key;
+            expand(key, static_cast<uint8_t>(key[0]), 0, true);
+            std::sort(found_.begin(), found_.end());
+            st.endBegin = static_cast<uint32_t>(endPool_.size());
+            st.endCount = static_cast<uint32_t>(found_.size());
+            endPool_.insert(endPool_.end(), found_.begin(), found_.end());
+        }
+        return {endPool_.data() + st.endBegin, st.endCount};
+    }
+
+    /* -- NFA-Schritte --------------------------------------------------- */
+
+    bool holds(RegexKind assertion, uint8_t flags, unsigned char c, bool end) const {
+        switch (assertion) {
+        case RegexKind::BeginText:       return flags & AT_START;
+        case RegexKind::EndText:         return end;
+        case RegexKind::BeginLine:       return flags & (AT_START | AFTER_NEWLINE);
+        case RegexKind::EndLine:         return end || c == '\n';
+        case RegexKind::WordBoundary:    return bool(flags & AFTER_WORD) != (!end && is_word(c));
+        case RegexKind::NotWordBoundary: return bool(flags & AFTER_WORD) == (!end && is_word(c));
+        default:                         return false;
+        }
+    }
+
+    // Offene Instruktionen des Zustands vor Byte c (bzw. am Textende):
+    // Zusicherungen auswerten, Treffer nach found_, Nachfolger der
+    // passenden Byte-Instruktionen nach stepped_
+    void expand(const std::string &key, uint8_t flags, unsigned char c, bool end) {
+        found_.clear();
+        stepped_.clear();
+        stack_.clear();
+        const uint32_t skip = key_word(key, 0) + 1;
+        for (size_t i = skip, n = (key.size() - 1) / 4; i < n; ++i) stack_.push_back(key_word(key, i));
+        const uint32_t gen = next_gen();
+        while (!stack_.empty()) {
+            const uint32_t pc = stack_.back();
+            stack_.pop_back();
+            if (mark_[pc] == gen) continue;
+            mark_[pc]      = gen;
+            const Inst &in = program_.insts[pc];
+            switch (in.op) {
+            case Op::Byte:
+                if (!end && in.set.test(c)) stepped_.push_back(in.out);
+                break;
+            case Op::Match:
+                found_.push_back(in.out);
+                break;
+            case Op::Split:
+                stack_.push_back(in.out1);
+                stack_.push_back(in.out);
+                break;
+            case Op::Nop:
+                stack_.push_back(in.out);
+                break;
+            case Op::Assert:
+                if (holds(in.assertion, flags, c, end)) stack_.push_back(in.out);
+                break;
+            }
+        }
+    }
+
+    // Hülle über Split/Nop: die offenen Instruktionen ab pcs, sortiert nach list_
+    void closure(const std::vector<uint32_t> &pcs) {
+        list_.clear();
+        stack_.assign(pcs.rbegin(), pcs.rend());
+        const uint32_t gen = next_gen();
+        while (!stack_.empty()) {
+            const uint32_t pc = stack_.back();
+            stack_.pop_back();
+            if (mark_[pc] == gen) continue;
+            mark_[pc]      = gen;
+            const Inst &in = program_.insts[pc];
+            if (in.op == Op::Split) {
+                stack_.push_back(in.out1);
+                stack_.push_back(in.out);
+            } else if (in.op == Op::Nop) {
+                stack_.push_back(in.out);
+            } else {
+                list_.push_back(pc);
+            }
+        }
+        std::sort(list_.begin(), list_.end());
+    }
+
+    uint32_t next_gen() {
+        if (++gen_ == 0) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            gen_ = 1;
+        }
+        return gen_;
+    }
+
+    const Program                            &program_;
+    size_t                                    budget_, used_ = 0;
+    size_t                                   &resets_;
+    std::array<uint8_t, 256>                  classOf_{};
+    uint32_t                                  classes_ = 1;
+    std::vector<State>                        states_;
+    std::vector<uint32_t>                     trans_;   // states_ × classes_
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<uint32_t>                     endPool_;
+    uint32_t                                  start_ = NONE;
+    uint32_t                                  search_ = 0;
+
+    // Arbeitsspeicher der Schritte
+    std::vector<uint32_t> mark_;
+    uint32_t              gen_ = 0;
+    std::vector<uint32_t> stack_, list_, found_, stepped_;
+};
+
+/* ------------------------------------------------------------------ *
+ *  RegexSet
+ * ------------------------------------------------------------------ */
+
+RegexSet::RegexSet(size_t cacheBytes) : cacheBytes_(cacheBytes) {}
+
+RegexSet::~RegexSet() = default;
+
+namespace {
+
+// Thompson-Programm von pattern hinter insts; Startinstruktion oder NONE
+uint32_t compile(std::string_view pattern, uint32_t n, std::vector<Inst> &insts, bool &assertions,
+                 Required *literal = nullptr) {
+    // Wie Chrome ohne isUrlFilterCaseSensitive; Klassen faltet der
+    // Parser dann schon vor dem Negieren
+    const RegexAst ast = parse_regex("(?i)" + std::string(pattern));
+    if (ast.error != RegexError::None) return NONE;
+    Compiler       compiler(ast, insts);
+    const uint32_t start = compiler.run(n);
+    assertions |= compiler.assertions();
+    if (literal) *literal = required(ast, ast.root);
+    return start;
+}
+
+}  // namespace
+
+int RegexSet::add(std::string_view pattern) {
+    std::vector<Inst> insts;
+    bool              assertions = false;
+    Required          req;
+    if (compile(pattern, 0, insts, assertions, &req) == NONE) {
+        ++stats_.rejected;
+        return -1;
+    }
+    patterns_.emplace_back(pattern);
+    literals_.push_back(req.best.size() >= MIN_LITERAL ? std::move(req.best) : std::string());
+    built_ = false;
+    return static_cast<int>(patterns_.size() - 1);
+}
+
+// Jedes Muster mit Literal kommt in das Programm des Trigramms aus
+// seinem Literal, das die wenigsten Literale enthalten
+void RegexSet::build() {
+    std::unordered_map<uint32_t, uint32_t> frequency;
+    std::vector<uint32_t>                  grams;
+    auto trigrams_of = [&](const std::string &literal) {
+        grams.clear();
+        for (size_t i = 0; i + MIN_LITERAL <= literal.size(); ++i) grams.push_back(trigram(&literal[i]));
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    };
+    for (const std::string &literal : literals_) {
+        trigrams_of(literal);
+        for (const uint32_t t : grams) ++frequency[t];
+    }
+
+    programs_.assign(1, Program{});
+    byTrigram_.clear();
+    trigramBits_.assign(TRIGRAM_BITS / 64, 0);
+    stats_.prefiltered = stats_.combined = 0;
+    for (uint32_t n = 0; n < patterns_.size(); ++n) {
+        uint32_t program = 0;
+        trigrams_of(literals_[n]);
+        if (!grams.empty()) {
+            const uint32_t t = *std::min_element(grams.begin(), grams.end(), [&](uint32_t a, uint32_t b) {
+                return frequency[a] < frequency[b];
+            });
+            const auto [it, added] = byTrigram_.emplace(t, static_cast<uint32_t>(programs_.size()));
+            if (added) programs_.emplace_back();
+            trigramBits_[trigram_bit(t) / 64] |= uint64_t(1) << (trigram_bit(t) % 64);
+            program = it->second;
+        }
+        Program &p = programs_[program];
+        p.starts.push_back(compile(patterns_[n], n, p.insts, p.assertions));
+        ++(program ? stats_.prefiltered : stats_.combined);
+    }
+
+    dfas_.clear();
+    dfas_.reserve(programs_.size());
+    for (const Program &p : programs_) dfas_.emplace_back(p, cacheBytes_, resets_);
+    seen_.assign(programs_.size(), 0);
+    stamp_ = 0;
+    built_ = true;
+}
+
+void RegexSet::search(std::string_view text, std::vector<uint64_t> &hits) const {
+    hits.assign((patterns_.size() + 63) / 64, 0);
+    if (!built_) return;
+    if (!programs_[0].starts.empty()) dfas_[0].search(text, hits);
+    if (programs_.size() == 1 || text.size() < MIN_LITERAL) return;
+
+    // Jedes Programm, dessen Trigramm im Text steht, läuft einmal
+    if (++stamp_ == 0) {
+        std::fill(seen_.begin(), seen_.end(), 0);
+        stamp_ = 1;
+    }
+    for (size_t i = 0; i + MIN_LITERAL <= text.size(); ++i) {
+        const uint32_t t   = trigram(text.data() + i);
+        const size_t   bit = trigram_bit(t);
+        if (!(trigramBits_[bit / 64] >> (bit % 64) & 1)) continue;
+        const auto it = byTrigram_.find(t);
+        if (it == byTrigram_.end() || seen_[it->second] == stamp_) continue;
+        seen_[it->second] = stamp_;
+        dfas_[it->second].search(text, hits);
+    }
+}
+
+RegexSetStats RegexSet::stats() const {
+    RegexSetStats s = stats_;
+    s.patterns      = patterns_.size();
+    s.programs      = programs_.size();
+    for (const Dfa &d : dfas_) s.states += d.states();
+    s.resets = resets_;
+    return s;
+}
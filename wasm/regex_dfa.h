@@ -0,0 +1,87 @@
+/***********************************************************************
+ *  Lazy-DFA für regexFilter
+ *
+ *  Prüft viele Muster in RE2-Syntax (regex.h) gegen einen Text, in
+ *  linearer Zeit und ohne Backtracking:
+ *
+ *    – Thompson-Konstruktion: jedes Muster wird aus seinem Syntaxbaum
+ *      in NFA-Instruktionen übersetzt (Byte-Mengen, Verzweigungen,
+ *      Zusicherungen ^ $ \b \B, am Ende ein Match mit seiner Nummer)
+ *    – DFA-Zustände (Mengen von NFA-Instruktionen) entstehen erst beim
+ *      Suchen; Übergänge je Byte-Klasse bleiben im Cache.  Wächst der
+ *      über sein Budget, wird er geleert und neu aufgebaut (wie RE2)
+ *    – mehrere Muster teilen sich ein Programm; ein Durchlauf seiner
+ *      DFA meldet jedes davon, das irgendwo trifft
+ *    – Literal-Vorfilter: enthält jeder Treffer eines Musters ein
+ *      festes Literal (mindestens 3 Zeichen), kommt es in das Programm
+ *      des seltensten Trigramms daraus, und das läuft nur, wenn das
+ *      Trigramm im Text steht.  Die Trigramme sucht ein Durchlauf über
+ *      den Text; Muster ohne Literal laufen immer (ein Programm)
+ *
+ *  Semantik wie Chromes regexFilter: Treffer irgendwo im Text, Latin-1,
+ *  ohne Rücksicht auf Groß-/Kleinschreibung (ASCII).  Nur nativ, nicht
+ *  Teil des WASM-Builds.  Suchen füllt die Caches und ist daher nicht
+ *  threadsicher.
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct RegexSetStats {
+    size_t patterns    = 0;     // übersetzt
+    size_t rejected    = 0;     // von parse_regex abgelehnt oder zu groß
+    size_t prefiltered = 0;     // über ein Literal-Trigramm vorgefiltert
+    size_t combined    = 0;     // ohne Literal, im Programm für jeden Text
+    size_t programs    = 0;     // NFA-Programme (je Trigramm eines, dazu das ohne)
+    size_t states      = 0;     // DFA-Zustände derzeit im Cache (alle DFAs)
+    size_t resets      = 0;     // Cache-Leerungen seit build()
+};
+
+class RegexSet {
+public:
+    // Budget je DFA für Zustände und Übergänge
+    static constexpr size_t DEFAULT_CACHE_BYTES = size_t(1) << 20;
+
+    explicit RegexSet(size_t cacheBytes = DEFAULT_CACHE_BYTES);
+    ~RegexSet();
+    RegexSet(const RegexSet &)            = delete;
+    RegexSet &operator=(const RegexSet &) = delete;
+
+    // Nummer des Musters (fortlaufend ab 0) oder -1, wenn es sich nicht
+    // übersetzen lässt
+    int add(std::string_view pattern);
+
+    // Verteilt die Muster auf Programme; nach dem letzten add(), vor
+    // dem ersten search()
+    void build();
+
+    // Setzt in hits (ein Bit je Muster, Bit n in hits[n / 64]) genau die
+    // Muster, die irgendwo in text treffen
+    void search(std::string_view text, std::vector<uint64_t> &hits) const;
+
+    size_t        size() const { return patterns_.size(); }
+    RegexSetStats stats() const;
+
+private:
+    struct Program;
+    struct Dfa;
+
+    size_t                                 cacheBytes_;
+    std::vector<std::string>               patterns_;
+    std::vector<std::string>               literals_;      // je Muster, klein; leer = ohne Vorfilter
+    bool                                   built_ = false;
+    std::vector<Program>                   programs_;      // [0] ohne Vorfilter, dann je Trigramm
+    std::unordered_map<uint32_t, uint32_t> byTrigram_;     // drei Zeichen → programs_
+    std::vector<uint64_t>                  trigramBits_;   // grobe Vorauswahl für byTrigram_
+    mutable std::vector<Dfa>               dfas_;          // je Programm
+    mutable std::vector<uint32_t>          seen_;          // je Programm: Stempel der Suche
+    mutable uint32_t                       stamp_  = 0;
+    mutable size_t                         resets_ = 0;
+    RegexSetStats                          stats_;
+};
@@ -0,0 +1,227 @@
+/***********************************************************************
+ *  Text-Scan-Helfer für den Filter-Parser
+ *
+ *  Zeilen werden als std::string_view direkt aus dem Eingabepuffer
+ *  geliefert – keine Kopie pro Zeile, kein iostream.  Die Suche nach
+ *  '\n' läuft 16 Bytes breit (SSE2 nativ, simd128 unter WASM), der
+ *  Rest fällt auf memchr zurück.  Ebenso breit klassifiziert
+ *  classify_line eine Zeile in einem einzigen Durchlauf.
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+/* ------------------------------------------------------------------ *
+ *  Vektorisierte Newline-Suche
+ * ------------------------------------------------------------------ */
+
+inline const char *find_newline(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#elif defined(__wasm_simd128__)
+    const v128_t nl = wasm_i8x16_splat('\n');
+    while (end - p >= 16) {
+        const v128_t v       = wasm_v128_load(p);
+        const uint32_t mask  = wasm_i8x16_bitmask(wasm_i8x16_eq(v, nl));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    const void *hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return hit ? static_cast<const char *>(hit) : end;
+}
+
+/* ------------------------------------------------------------------ *
+ *  String-Helfer
+ * ------------------------------------------------------------------ */
+
+constexpr std::string_view WHITESPACE = " \t\r\n";
+
+inline std::string_view trim(std::string_view sv) {
+    const auto begin = sv.find_first_not_of(WHITESPACE);
+    if (begin == std::string_view::npos) return {};
+    const auto end = sv.find_last_not_of(WHITESPACE);
+    return sv.substr(begin, end - begin + 1);
+}
+
+// Ruft cb für jedes Feld zwischen Delim auf; ein abschließender
+// Delimiter erzeugt kein leeres Feld
+template <char Delim, typename Callback>
+inline void split_sv(std::string_view sv, Callback &&cb) {
+    size_t start = 0;
+    for (size_t i = 0; i < sv.size(); ++i) {
+        if (sv[i] == Delim) {
+            cb(sv.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    if (start < sv.size()) cb(sv.substr(start));
+}
+
+/* ------------------------------------------------------------------ *
+ *  Zeilen-Iterator
+ *
+ *  Semantik wie std::getline(ss, buf, '\n'): ein abschließendes '\n'
+ *  erzeugt keine zusätzliche leere Zeile.  Zusätzlich wird ein
+ *  UTF-8-BOM am Anfang übersprungen (abschaltbar für Teil-Puffer) und
+ *  ein '\r' am Zeilenende (CRLF) abgeschnitten.
+ * ------------------------------------------------------------------ */
+
+class LineSplitter {
+public:
+    explicit LineSplitter(std::string_view text, bool skipBom = true)
+        : pos_(text.data()), end_(text.data() + text.size()) {
+        if (skipBom && text.starts_with("\xEF\xBB\xBF"))
+            pos_ += 3;
+    }
+
+    bool next(std::string_view &line) {
+        if (pos_ >= end_) return false;
+        const char *nl = find_newline(pos_, end_);
+        const char *e  = nl;
+        if (e > pos_ && e[-1] == '\r') --e;
+        line = std::string_view(pos_, static_cast<size_t>(e - pos_));
+        pos_ = nl < end_ ? nl + 1 : end_;
+        return true;
+    }
+
+    // Restlicher, noch nicht gelieferter Teil des Puffers
+    std::string_view rest() const {
+        return std::string_view(pos_, static_cast<size_t>(end_ - pos_));
+    }
+
+private:
+    const char *pos_;
+    const char *end_;
+};
+
+/* ------------------------------------------------------------------ *
+ *  Zeilen-Klassifikation
+ *
+ *  Ein Durchlauf über die (getrimmte) Zeile sucht gleichzeitig nach
+ *  '#', '$', '/' und '*'.  Jeder Treffer wird skalar ausgewertet:
+ *    '#'  → Cosmetic-Marker "##", "#?#", "#$#", "#@#" (sofortiger Abbruch)
+ *    '$'  → erste Position = Trennung Filter / Optionen
+ *    '/', '*' vor dem '$' → Flags für die Domain-Prüfung
+ *  '|' und '@' sind nur als Präfix ("||", "@@") bzw. innerhalb der
+ *  Cosmetic-Marker relevant und werden dort direkt geprüft.
+ * ------------------------------------------------------------------ */
+
+enum class LineKind : uint8_t { Skip, Cosmetic, Network };
+
+struct LineClass {
+    LineKind kind   = LineKind::Network;
+    size_t   dollar = std::string_view::npos;  // erstes '$'
+    bool     slash  = false;                   // '/' vor dem ersten '$'
+    bool     star   = false;                   // '*' vor dem ersten '$'
+};
+
+namespace detail {
+
+// Wertet einen Treffer an Position i aus; true = Cosmetic-Zeile
+inline bool classify_hit(const char *p, size_t n, size_t i, LineClass &c) {
+    switch (p[i]) {
+        case '#':
+            if (i + 1 < n && p[i + 1] == '#') return true;
+            if (i + 2 < n && p[i + 2] == '#' &&
+                (p[i + 1] == '?' || p[i + 1] == '$' || p[i + 1] == '@'))
+                return true;
+            break;
+        case '$':
+            if (c.dollar == std::string_view::npos) c.dollar = i;
+            break;
+        case '/':
+            if (c.dollar == std::string_view::npos) c.slash = true;
+            break;
+        case '*':
+            if (c.dollar == std::string_view::npos) c.star = true;
+            break;
+    }
+    return false;
+}
+
+} // namespace detail
+
+inline LineClass classify_line(std::string_view line) {
+    LineClass c;
+    if (line.empty() || line[0] == '!' || line[0] == '[') {
+        c.kind = LineKind::Skip;
+        return c;
+    }
+
+    const char  *p = line.data();
+    const size_t n = line.size();
+    size_t       i = 0;
+
+#if defined(__SSE2__) || defined(__wasm_simd128__)
+    // Treffer-Maske für 16 Bytes ab q
+    auto block_mask = [](const char *q) -> unsigned {
+#if defined(__SSE2__)
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(q));
+        const __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('$'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('*'))));
+        return static_cast<unsigned>(_mm_movemask_epi8(m));
+#else
+        const v128_t v = wasm_v128_load(q);
+        const v128_t m = wasm_v128_or(
+            wasm_v128_or(wasm_i8x16_eq(v, wasm_i8x16_splat('#')),
+                         wasm_i8x16_eq(v, wasm_i8x16_splat('$'))),
+            wasm_v128_or(wasm_i8x16_eq(v, wasm_i8x16_splat('/')),
+                         wasm_i8x16_eq(v, wasm_i8x16_splat('*'))));
+        return wasm_i8x16_bitmask(m);
+#endif
+    };
+    auto scan = [&](size_t base, unsigned mask) {
+        for (; mask; mask &= mask - 1)
+            if (detail::classify_hit(p, n, base + __builtin_ctz(mask), c)) return true;
+        return false;
+    };
+
+    if (n < 16) {
+        // Kurze Zeile: in einen mit Nullen aufgefüllten Block kopieren
+        char buf[16] = {};
+        std::memcpy(buf, p, n);
+        if (scan(0, block_mask(buf))) c.kind = LineKind::Cosmetic;
+        return c;
+    }
+    for (; i + 16 <= n; i += 16)
+        if (scan(i, block_mask(p + i))) {
+            c.kind = LineKind::Cosmetic;
+            return c;
+        }
+    if (i < n) {
+        // Rest: überlappender letzter Block, bereits geprüfte Bytes ausblenden
+        const size_t base = n - 16;
+        if (scan(base, block_mask(p + base) & (~0u << (i - base)))) c.kind = LineKind::Cosmetic;
+    }
+#else
+    for (; i < n; ++i) {
+        const char ch = p[i];
+        if ((ch == '#' || ch == '$' || ch == '/' || ch == '*') &&
+            detail::classify_hit(p, n, i, c)) {
+            c.kind = LineKind::Cosmetic;
+            return c;
+        }
+    }
+#endif
+    return c;
+}
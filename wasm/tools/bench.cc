@@ -0,0 +1,407 @@
+/***********************************************************************
+ *  Nativer Benchmark für den Filter-Parser
+ *
+ *  Aufruf:  build/bench [--lines N] [--json] [liste.txt ...]
+ *           build/bench --gen N [--seed S] [--mix spec] [--json]
+ *
+ *  Ohne Datei wird ../filter_lists/filter.txt gelesen.  Mit --lines
+ *  wird die Eingabe so oft wiederholt, bis mindestens N Zeilen
+ *  vorliegen.  --gen erzeugt stattdessen eine synthetische Liste mit
+ *  N Zeilen (siehe listgen.h) – die Standard-Eingabe für Messungen
+ *  im großen Maßstab.
+ *
+ *  Neben der Zeit wird die Zahl der Heap-Allokationen (globaler
+ *  operator new) pro Einheit im ersten Durchlauf gemeldet.  Mit --json
+ *  erscheint statt der Tabelle ein JSON-Dokument auf stdout, damit
+ *  Läufe über die Zeit verglichen werden können.
+ ***********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "listgen.h"
+#include "nlohmann/json.hpp"
+#include "optimize.h"
+#include "parser.h"
+#include "text_scan.h"
+
+using json = nlohmann::json;
+
+/* ------------------------------------------------------------------ *
+ *  Allokationszähler
+ * ------------------------------------------------------------------ */
+
+static std::atomic<size_t> g_allocs{0};
+
+// GCC hält free() nach ersetztem operator new fälschlich für unpassend
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+/* ------------------------------------------------------------------ *
+ *  Hilfs-Utilities
+ * ------------------------------------------------------------------ */
+
+static std::string read_file(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        std::exit(1);
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+static size_t count_lines(std::string_view text) {
+    LineSplitter     lines(text);
+    std::string_view line;
+    size_t           n = 0;
+    while (lines.next(line)) ++n;
+    return n;
+}
+
+struct Result {
+    std::string name;
+    std::string unit;
+    double      seconds;    // beste Einzelmessung
+    size_t      count;
+    size_t      bytes;
+    size_t      allocs;     // im ersten Durchlauf
+};
+
+static std::vector<Result> g_results;
+static bool                g_json = false;
+
+// Wiederholt fn, bis mindestens ~0.5 s vergangen sind, und meldet die
+// beste Einzelmessung.  `count` Einheiten (Zeilen bzw. Regeln) und
+// `bytes` Bytes werden pro Durchlauf verarbeitet.  Allokationen werden
+// im ersten Durchlauf gezählt.
+template <typename Fn>
+static void run(const char *name, const char *unit, size_t bytes, size_t count, Fn &&fn) {
+    using clock = std::chrono::steady_clock;
+    double best  = 1e300;
+    double total = 0;
+    int    iters = 0;
+    size_t allocs = 0;
+    while (total < 0.5 || iters < 3) {
+        const size_t a0 = g_allocs.load(std::memory_order_relaxed);
+        const auto   t0 = clock::now();
+        fn();
+        const double s = std::chrono::duration<double>(clock::now() - t0).count();
+        if (iters == 0) allocs = g_allocs.load(std::memory_order_relaxed) - a0;
+        best = std::min(best, s);
+        total += s;
+        ++iters;
+    }
+    g_results.push_back({name, unit, best, count, bytes, allocs});
+    if (g_json) return;
+    std::printf("%-30s %10.3f ms  %12.0f %s/s  %8.1f ns/%s  %8.1f MB/s  %7.3f alloc/%s\n",
+                name, best * 1e3, count / best, unit, best * 1e9 / count, unit,
+                bytes / best / 1e6, double(allocs) / count, unit);
+}
+
+static void print_json(const json &input) {
+    json doc;
+    doc["input"] = input;
+    json &results = doc["results"] = json::array();
+    for (const auto &r : g_results) {
+        results.push_back({{"name", r.name},
+                           {"unit", r.unit},
+                           {"count", r.count},
+                           {"ms", r.seconds * 1e3},
+                           {"perSecond", r.count / r.seconds},
+                           {"nsPerUnit", r.seconds * 1e9 / r.count},
+                           {"mbPerSecond", r.bytes / r.seconds / 1e6},
+                           {"allocsPerUnit", double(r.allocs) / r.count}});
+    }
+    std::printf("%s\n", doc.dump(2).c_str());
+}
+
+static volatile size_t sink;
+
+/* ------------------------------------------------------------------ *
+ *  main
+ * ------------------------------------------------------------------ */
+
+int main(int argc, char **argv) {
+    size_t                    minLines = 0, genLines = 0;
+    uint64_t                  seed     = 1;
+    const char               *mixSpec  = "";
+    ListMix                   mix;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--lines" && i + 1 < argc)     minLines = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--gen" && i + 1 < argc)  genLines = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--seed" && i + 1 < argc) seed     = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--mix" && i + 1 < argc) {
+            mixSpec = argv[++i];
+            if (!parse_list_mix(mixSpec, mix)) {
+                std::fprintf(stderr, "invalid --mix %s\n", mixSpec);
+                return 2;
+            }
+        }
+        else if (a == "--json") g_json = true;
+        else files.push_back(argv[i]);
+    }
+    if (files.empty() && !genLines) files.push_back("../filter_lists/filter.txt");
+
+    std::string text;
+    json        input;
+    if (genLines) {
+        text  = ListGenerator(seed, mix).generate(genLines);
+        input = {{"generated", {{"lines", genLines}, {"seed", seed}, {"mix", mixSpec}}}};
+    } else {
+        for (const char *f : files) text += read_file(f);
+        input = {{"files", files}};
+    }
+    if (!text.empty() && text.back() != '\n') text.push_back('\n');
+    if (minLines) {
+        const std::string unit  = text;
+        const size_t      per   = count_lines(unit);
+        for (size_t n = per; per && n < minLines; n += per) text += unit;
+    }
+
+    const size_t bytes = text.size();
+    const size_t lines = count_lines(text);
+    input["lines"] = lines;
+    input["bytes"] = bytes;
+    if (!g_json) std::printf("input: %zu lines, %.2f MB\n\n", lines, bytes / 1e6);
+
+    /* -- Zeilen-Splitting ------------------------------------------ */
+    run("split: stringstream+getline", "line", bytes, lines, [&] {
+        std::stringstream ss(text);
+        std::string       buf;
+        size_t            n = 0;
+        while (std::getline(ss, buf, '\n')) n += buf.size();
+        sink = n;
+    });
+    run("split: LineSplitter", "line", bytes, lines, [&] {
+        LineSplitter     it(text);
+        std::string_view line;
+        size_t           n = 0;
+        while (it.next(line)) n += line.size();
+        sink = n;
+    });
+
+    /* -- Zeilen-Klassifikation ------------------------------------- */
+    run("classify: 4x find + find('$')", "line", bytes, lines, [&] {
+        LineSplitter     it(text);
+        std::string_view line;
+        size_t           n = 0;
+        while (it.next(line)) {
+            if (line.find("##") != std::string_view::npos ||
+                line.find("#?#") != std::string_view::npos ||
+                line.find("#$#") != std::string_view::npos ||
+                line.find("#@#") != std::string_view::npos)
+                continue;
+            n += line.find('$');
+        }
+        sink = n;
+    });
+    run("classify: classify_line", "line", bytes, lines, [&] {
+        LineSplitter     it(text);
+        std::string_view line;
+        size_t           n = 0;
+        while (it.next(line)) {
+            const LineClass c = classify_line(line);
+            if (c.kind == LineKind::Network) n += c.dollar;
+        }
+        sink = n;
+    });
+
+    /* -- Fast-Path "||host^" --------------------------------------- */
+    {
+        // Nur die nackten "||host^"-Zeilen.  Mit angehängtem leeren
+        // Optionsteil ("$") entsteht dieselbe Regel, aber über den
+        // generischen Pfad.  Gemessen wird parse_line + write_rule_json
+        // in einen wiederverwendeten Puffer (ohne Container-Wachstum).
+        std::vector<std::string> plain, forced;
+        size_t                   plainBytes = 0;
+        LineSplitter             it(text);
+        std::string_view         line;
+        while (it.next(line)) {
+            const LineClass c = classify_line(line);
+            if (c.kind == LineKind::Network && c.dollar == std::string_view::npos &&
+                !c.slash && !c.star && line.starts_with("||") && line.ends_with('^')) {
+                plain.emplace_back(line);
+                forced.emplace_back(std::string(line) + "$");
+                plainBytes += line.size() + 1;
+            }
+        }
+        std::string buf;
+        RuleArena   arena;
+        auto parse_all = [&](const std::vector<std::string> &in) {
+            arena.release();
+            size_t n = 0;
+            for (const auto &l : in) {
+                buf.clear();
+                if (auto r = parse_line(l, 1, arena)) write_rule_json(buf, *r, arena.domains());
+                n += buf.size();
+            }
+            sink = n;
+        };
+        if (!plain.empty()) {
+            run("||host^: generic path", "line", plainBytes, plain.size(),
+                [&] { parse_all(forced); });
+            run("||host^: fast path", "line", plainBytes, plain.size(),
+                [&] { parse_all(plain); });
+        }
+    }
+
+    /* -- Optionen -------------------------------------------------- */
+    {
+        // Synthetische Zeilen mit vielen Options-Schlüsseln, damit der
+        // Keyword-Lookup in parse_options den Großteil der Zeit ausmacht.
+        static const char *const OPTS[] = {
+            "$script,image,third-party",
+            "$xhr,~media,~font,important",
+            "$domain=a.com|~b.com,subdocument,popup",
+            "$method=get|post,~websocket,match-case",
+            "$stylesheet,ping,other,1p,badfilter"};
+        std::vector<std::string> optLines;
+        size_t                   optBytes = 0;
+        for (size_t i = 0; i < 20000; ++i) {
+            optLines.push_back("||ads" + std::to_string(i) + ".example^" + OPTS[i % 5]);
+            optBytes += optLines.back().size() + 1;
+        }
+        // Optionsteile allein (hinter '$')
+        std::vector<std::string_view> optParts;
+        for (const auto &l : optLines) optParts.push_back(std::string_view(l).substr(l.find('$') + 1));
+
+        std::string buf;
+        RuleArena   arena;
+        run("options: trim + split_sv", "line", optBytes, optParts.size(), [&] {
+            size_t n = 0;
+            for (const auto o : optParts)
+                split_sv<','>(o, [&](std::string_view opt) {
+                    opt = trim(opt);
+                    split_sv<'|'>(opt, [&](std::string_view v) { n += trim(v).size(); });
+                });
+            sink = n;
+        });
+        run("options: parse_options", "line", optBytes, optParts.size(), [&] {
+            arena.release();
+            size_t n = 0;
+            for (const auto o : optParts) {
+                DnrRule rule;
+                parse_options(o, rule, arena);
+                n += rule.conditionResourceTypes + rule.conditionInitiatorDomains.size();
+            }
+            sink = n;
+        });
+        run("parse_line: option-heavy", "line", optBytes, optLines.size(), [&] {
+            arena.release();
+            size_t n = 0;
+            for (const auto &l : optLines) {
+                buf.clear();
+                if (auto r = parse_line(l, 1, arena)) write_rule_json(buf, *r, arena.domains());
+                n += buf.size();
+            }
+            sink = n;
+        });
+    }
+
+    /* -- Einzelzeilen der Eingabe ---------------------------------- */
+    std::vector<DnrRule> rules;
+    RuleArena            ruleArena;
+    run("parse_line: input", "line", bytes, lines, [&] {
+        rules.clear();
+        ruleArena.release();
+        LineSplitter     it(text);
+        std::string_view line;
+        while (it.next(line))
+            if (auto r = parse_line(line, static_cast<int>(rules.size()) + 1, ruleArena))
+                rules.push_back(*r);
+        sink = rules.size();
+    });
+
+    /* -- Optimierungs-Pässe ---------------------------------------- */
+    {
+        std::vector<DnrRule> work, unique = rules;
+        remove_duplicate_rules(unique);
+        RuleArena passArena;
+        run("optimize: lower_regex", "rule", 0, rules.size(), [&] {
+            work = rules;
+            passArena.release();
+            sink = lower_regex_rules(work, passArena);
+        });
+        run("optimize: reject_regex", "rule", 0, rules.size(), [&] {
+            work = rules;
+            sink = drop_unsupported_regex_rules(work, nullptr);
+        });
+        run("optimize: remove_duplicates", "rule", 0, rules.size(), [&] {
+            work = rules;
+            sink = remove_duplicate_rules(work);
+        });
+        run("optimize: prune_shadowed", "rule", 0, unique.size(), [&] {
+            work = unique;
+            sink = prune_shadowed_rules(work, ruleArena.domains(), nullptr);
+        });
+        run("optimize: prune_subsumed", "rule", 0, unique.size(), [&] {
+            work = unique;
+            sink = prune_subsumed_rules(work, ruleArena.domains());
+        });
+        // Die Hosts kommen in die Domain-Tabelle der Regeln, also in deren Arena
+        run("optimize: coalesce_domains", "rule", 0, unique.size(), [&] {
+            work = unique;
+            sink = coalesce_domain_rules(work, ruleArena, OptimizeOptions{}.maxRequestDomains);
+        });
+        run("optimize: select_within_budget", "rule", 0, unique.size(), [&] {
+            work = unique;
+            BudgetReport report;
+            sink = select_rules_within_budget(work, ruleArena.domains(), unique.size() / 2, nullptr,
+                                              report);
+        });
+    }
+
+    /* -- Serialisierung -------------------------------------------- */
+    std::string ref;
+    const DomainTable &domains = ruleArena.domains();
+    for (const auto &r : rules) write_rule_json(ref, r, domains);
+
+    run("json: rule_to_json + dump", "rule", ref.size(), rules.size(), [&] {
+        json arr = json::array();
+        for (const auto &r : rules) arr.push_back(rule_to_json(r, domains));
+        sink = arr.dump(-1, ' ', false, json::error_handler_t::ignore).size();
+    });
+    run("json: write_rule_json", "rule", ref.size(), rules.size(), [&] {
+        std::string out;
+        out.reserve(rules.size() * 96);
+        for (const auto &r : rules) {
+            if (!out.empty()) out.push_back(',');
+            write_rule_json(out, r, domains);
+        }
+        sink = out.size();
+    });
+
+    /* -- Ende-zu-Ende ---------------------------------------------- */
+    run("parseFilterList", "line", bytes, lines, [&] {
+        sink = parseFilterList(text).size();
+    });
+    run("parseFilterListWasm", "line", bytes, lines, [&] {
+        sink = parseFilterListWasm(text, 0).size();    // inkl. Kopie wie bei embind
+    });
+    run("parseFilterListParallel", "line", bytes, lines, [&] {
+        sink = parseFilterListParallel(text).size();
+    });
+
+    if (g_json) print_json(input);
+    return 0;
+}
@@ -0,0 +1,149 @@
+/***********************************************************************
+ *  canoncheck – Normalform der urlFilter gegen den Referenz-Matcher
+ *
+ *  Aufruf:  build/canoncheck [--filters N] [--urls N] [--seed S]
+ *
+ *  Erzeugt zufällige urlFilter aus einem kleinen Alphabet (Anker, '*',
+ *  '**', '^', wörtliches '|', Groß-/Kleinschreibung) und prüft für
+ *  jeden, dass canonical_url_filter
+ *    – idempotent ist und
+ *    – auf zufälligen sowie aus dem Muster abgeleiteten URLs genau
+ *      dieselben Treffer liefert wie das Original (urlfilter_ref.h).
+ *  Abweichungen landen auf stderr, der Exit-Code ist dann 1.
+ ***********************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parser.h"
+#include "urlfilter_ref.h"
+
+// splitmix64 – deterministisch auf jeder Plattform
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z          = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+
+    template <size_t N>
+    std::string_view pick(const std::string_view (&items)[N]) { return items[below(N)]; }
+
+private:
+    uint64_t state_;
+};
+
+static constexpr std::string_view FILTER_TOKENS[] = {
+    "a", "b", "Ad", "x.", ".com", "/", "/ad", "-", "_", "%2f", ":", "?", "=",
+    "*", "*", "**", "^", "^", "|", "ad"};
+static constexpr std::string_view HOST_LABELS[] = {"a", "ad", "ads", "b", "x-a", "com", "Ad"};
+static constexpr std::string_view URL_TOKENS[] = {
+    "a", "b", "ad", "AD", "x.", ".com", "/", "-", "_", "%2f", ":", "?", "=", "&", "|", "^", ""};
+static constexpr std::string_view SCHEMES[] = {"https://", "http://", "wss://"};
+
+static std::string random_filter(Rng &rng) {
+    std::string f;
+    const size_t anchor = rng.below(4);
+    if (anchor == 1) f += '|';
+    if (anchor == 2) {
+        f += "||";
+        f += rng.pick(HOST_LABELS);
+    }
+    for (size_t n = rng.below(7); n > 0; --n) f += rng.pick(FILTER_TOKENS);
+    if (rng.below(4) == 0) f += '|';
+    if (f.empty() || f == "|" || f == "||") f += 'a';
+    return f;
+}
+
+static std::string random_url(Rng &rng) {
+    std::string u(rng.pick(SCHEMES));
+    for (size_t n = 1 + rng.below(3); n > 0; --n) {
+        u += rng.pick(HOST_LABELS);
+        if (n > 1) u += '.';
+    }
+    if (rng.below(4) == 0) u += ":8080";
+    u += '/';
+    for (size_t n = rng.below(6); n > 0; --n) u += rng.pick(URL_TOKENS);
+    return u;
+}
+
+// URL, die das Muster wahrscheinlich trifft: Platzhalter ersetzt, vorn
+// und hinten (soweit nicht verankert) zufällig ergänzt
+static std::string url_for(std::string_view filter, Rng &rng) {
+    std::string u;
+    if (filter.starts_with("||")) {
+        u = std::string(rng.pick(SCHEMES));
+        if (rng.below(2)) u += std::string(rng.pick(HOST_LABELS)) + ".";
+        filter.remove_prefix(2);
+    } else if (filter.starts_with('|')) {
+        filter.remove_prefix(1);
+    } else {
+        u = random_url(rng);
+    }
+    const bool rightAnchor = !filter.empty() && filter.back() == '|';
+    if (rightAnchor) filter.remove_suffix(1);
+    for (const char c : filter) {
+        if (c == '*')      u += rng.pick(URL_TOKENS);
+        else if (c == '^') u += rng.below(3) ? "/" : "";
+        else               u += c;
+    }
+    if (!rightAnchor && rng.below(2)) u += rng.pick(URL_TOKENS);
+    return u;
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: canoncheck [--filters N] [--urls N] [--seed S]\n");
+    std::exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t   filters = 200000, urls = 64;
+    uint64_t seed    = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--filters" && i + 1 < argc)   filters = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--urls" && i + 1 < argc) urls    = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--seed" && i + 1 < argc) seed    = std::strtoull(argv[++i], nullptr, 10);
+        else                                    usage();
+    }
+
+    Rng       rng(seed);
+    RuleArena arena;
+    size_t    rewritten = 0, compared = 0, mismatches = 0;
+    for (size_t n = 0; n < filters; ++n) {
+        if (n % 4096 == 0) arena.release();
+        const std::string      filter = random_filter(rng);
+        const std::string_view canon  = canonical_url_filter(filter, arena);
+        if (canon != filter) ++rewritten;
+
+        const std::string_view again = canonical_url_filter(canon, arena);
+        if (again != canon) {
+            if (++mismatches <= 20)
+                std::fprintf(stderr, "not idempotent: %s -> %.*s -> %.*s\n", filter.c_str(),
+                             int(canon.size()), canon.data(), int(again.size()), again.data());
+            continue;
+        }
+        for (size_t k = 0; k < urls; ++k) {
+            const std::string url = k % 2 ? random_url(rng) : url_for(filter, rng);
+            ++compared;
+            const bool want = urlfilter_ref::matches(filter, url);
+            if (urlfilter_ref::matches(canon, url) == want) continue;
+            if (++mismatches <= 20)
+                std::fprintf(stderr, "mismatch: %s -> %.*s on %s (original %s)\n", filter.c_str(),
+                             int(canon.size()), canon.data(), url.c_str(), want ? "matches" : "misses");
+            break;
+        }
+    }
+    std::printf("canoncheck: %zu filters (%zu rewritten), %zu URL comparisons, %zu mismatches\n",
+                filters, rewritten, compared, mismatches);
+    return mismatches ? 1 : 0;
+}
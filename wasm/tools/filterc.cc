@@ -0,0 +1,93 @@
+/***********************************************************************
+ *  filterc – nativer Filter-List-Compiler
+ *
+ *  Aufruf:  build/filterc [-j N] [--max-domains N] [--shadow-report]
+ *                        [--max-rules N [--weights profil.txt]] [-o out.json]
+ *                        liste.txt [...]
+ *
+ *  Mehrere Listen werden zu einer zusammengefügt.  -j legt die Zahl
+ *  der Threads fest (Standard: alle Kerne, 1 = sequentiell).
+ *  --max-domains begrenzt die Größe zusammengefasster requestDomains-
+ *  Regeln (0 = nicht zusammenfassen).  --shadow-report schreibt die
+ *  entfernten, von Ausnahmen verdeckten block-Regeln als "shadowReport"
+ *  (Zeilennummern der zusammengefügten Eingabe) mit in die Ausgabe.
+ *  --max-rules wählt höchstens N Regeln nach Nutzen aus und schreibt
+ *  einen "budgetReport"; --weights liest dafür ein Trefferprofil
+ *  ("domain gewicht" je Zeile, siehe DomainWeights).
+ ***********************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "optimize.h"
+#include "parser.h"
+
+static std::string read_file(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "filterc: cannot open %s\n", path);
+        std::exit(1);
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: filterc [-j threads] [--max-domains N] [--shadow-report] "
+                         "[--max-rules N [--weights profile.txt]] [-o out.json] list.txt [...]\n");
+    std::exit(2);
+}
+
+int main(int argc, char **argv) {
+    unsigned                  threads = 0;
+    OptimizeOptions           options;
+    const char               *outPath = nullptr;
+    const char               *weightsPath = nullptr;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "-j" && i + 1 < argc)      threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--max-domains" && i + 1 < argc)
+            options.maxRequestDomains = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--shadow-report")    options.reportShadowed = true;
+        else if (a == "--max-rules" && i + 1 < argc)
+            options.maxRules = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--weights" && i + 1 < argc) weightsPath = argv[++i];
+        else if (a == "-o" && i + 1 < argc) outPath = argv[++i];
+        else if (a.starts_with('-'))        usage();
+        else                                files.push_back(argv[i]);
+    }
+    if (files.empty()) usage();
+
+    DomainWeights weights;
+    if (weightsPath) {
+        if (!parse_domain_weights(read_file(weightsPath), weights)) {
+            std::fprintf(stderr, "filterc: invalid weight profile %s\n", weightsPath);
+            return 1;
+        }
+        options.weights = &weights;
+    }
+
+    std::string text;
+    for (const char *f : files) {
+        text += read_file(f);
+        if (!text.empty() && text.back() != '\n') text.push_back('\n');
+    }
+
+    const std::string out = parseFilterListParallel(text, threads, options);
+
+    if (!outPath) {
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        return 0;
+    }
+    std::ofstream os(outPath, std::ios::binary);
+    if (!os.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        std::fprintf(stderr, "filterc: cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/***********************************************************************
+ *  genlist – synthetische Filterliste erzeugen
+ *
+ *  Aufruf:  build/genlist [--lines N] [--seed S] [--mix spec] [-o out.txt]
+ *
+ *  Standard: 100000 Zeilen, Seed 1, Mischung siehe ListMix.  spec
+ *  überschreibt einzelne Gewichte, z.B. "bare=40,options=30,dup=10".
+ ***********************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "listgen.h"
+
+static void usage() {
+    std::fprintf(stderr, "usage: genlist [--lines N] [--seed S] [--mix bare=60,path=10,...] "
+                         "[-o out.txt]\n");
+    std::exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t      lines   = 100000;
+    uint64_t    seed    = 1;
+    ListMix     mix;
+    const char *outPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--lines" && i + 1 < argc)     lines = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--seed" && i + 1 < argc) seed  = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--mix" && i + 1 < argc) {
+            if (!parse_list_mix(argv[++i], mix)) usage();
+        }
+        else if (a == "-o" && i + 1 < argc)     outPath = argv[++i];
+        else                                    usage();
+    }
+
+    const std::string text = ListGenerator(seed, mix).generate(lines);
+
+    if (!outPath) {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+    std::ofstream os(outPath, std::ios::binary);
+    if (!os.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+        std::fprintf(stderr, "genlist: cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
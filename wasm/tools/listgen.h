@@ -0,0 +1,319 @@
+/***********************************************************************
+ *  Synthetische Filterlisten für Skalierungs- und Regressionstests
+ *
+ *  Deterministisch: gleicher Seed und gleiche Mischung liefern auf
+ *  jeder Plattform byteweise dieselbe Liste (eigener PRNG, keine
+ *  std::*_distribution).  Die Mischung ist an zusammengeführten
+ *  Listen orientiert: überwiegend nackte "||domain^", dazu Pfade,
+ *  Regex-Regeln, "@@"-Ausnahmen, Zeilen mit vielen Optionen und
+ *  langen domain=-Listen, Cosmetic-Regeln, Kommentare und Duplikate.
+ ***********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* ------------------------------------------------------------------ *
+ *  Mischung (relative Gewichte)
+ * ------------------------------------------------------------------ */
+
+struct ListMix {
+    unsigned bare     = 60;   // ||domain^
+    unsigned path     = 10;   // ||domain/pfad, |https://…|, generische Muster
+    unsigned regex    = 1;    // /…/
+    unsigned allow    = 5;    // @@…
+    unsigned options  = 9;    // …$script,third-party,domain=a|b|~c…
+    unsigned cosmetic = 10;   // ##, #@#, #?#
+    unsigned comment  = 3;    // !, [Adblock Plus], Leerzeilen
+    unsigned dup      = 2;    // Wiederholung einer früheren Netzwerk-Regel
+};
+
+inline constexpr std::array<std::pair<std::string_view, unsigned ListMix::*>, 8> LIST_MIX_FIELDS = {{
+    {"bare", &ListMix::bare},         {"path", &ListMix::path},
+    {"regex", &ListMix::regex},       {"allow", &ListMix::allow},
+    {"options", &ListMix::options},   {"cosmetic", &ListMix::cosmetic},
+    {"comment", &ListMix::comment},   {"dup", &ListMix::dup}}};
+
+// "bare=50,regex=5" – nicht genannte Gewichte bleiben unverändert.
+// false bei unbekanntem Schlüssel oder ungültiger Zahl.
+inline bool parse_list_mix(std::string_view spec, ListMix &mix) {
+    while (!spec.empty()) {
+        const size_t     comma = spec.find(',');
+        std::string_view item  = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+
+        const size_t eq = item.find('=');
+        if (eq == std::string_view::npos) return false;
+        const std::string_view key = item.substr(0, eq), val = item.substr(eq + 1);
+
+        unsigned   weight = 0;
+        const auto res    = std::from_chars(val.data(), val.data() + val.size(), weight);
+        if (res.ec != std::errc{} || res.ptr != val.data() + val.size()) return false;
+
+        bool known = false;
+        for (const auto &[name, field] : LIST_MIX_FIELDS)
+            if (name == key) mix.*field = weight, known = true;
+        if (!known) return false;
+    }
+    unsigned total = 0;
+    for (const auto &f : LIST_MIX_FIELDS) total += mix.*f.second;
+    return total > 0;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Generator
+ * ------------------------------------------------------------------ */
+
+class ListGenerator {
+public:
+    explicit ListGenerator(uint64_t seed, const ListMix &mix = {}) : state_(seed), mix_(mix) {
+        for (const auto &f : LIST_MIX_FIELDS) total_ += mix_.*f.second;
+        // Kleiner Pool häufiger Domains: erzeugt Subdomain-Beziehungen
+        // und Wiederholungen über Regeltypen hinweg
+        for (int i = 0; i < 256; ++i) hot_.push_back(base_domain());
+    }
+
+    // Eine Zeile (ohne '\n') an out anhängen
+    void line(std::string &out) {
+        unsigned pick = static_cast<unsigned>(below(total_));
+        auto take = [&pick](unsigned w) {
+            if (pick < w) return true;
+            pick -= w;
+            return false;
+        };
+        const size_t start = out.size();
+        if (take(mix_.bare))          bare(out);
+        else if (take(mix_.path))     path(out);
+        else if (take(mix_.regex))    regex(out);
+        else if (take(mix_.allow))    allow(out);
+        else if (take(mix_.options))  options(out);
+        else if (take(mix_.cosmetic)) { cosmetic(out); return; }
+        else if (take(mix_.comment))  { comment(out); return; }
+        else                          { dup(out); return; }
+        remember(std::string_view(out).substr(start));
+    }
+
+    // `lines` Zeilen, jeweils mit '\n' abgeschlossen
+    std::string generate(size_t lines) {
+        std::string out;
+        out.reserve(lines * 32);
+        for (size_t i = 0; i < lines; ++i) {
+            line(out);
+            out.push_back('\n');
+        }
+        return out;
+    }
+
+private:
+    static constexpr std::string_view SYLLABLES[] = {
+        "ad",   "track", "pix",   "cdn",  "stat",  "metric", "click", "serve",
+        "net",  "media", "log",   "bea",  "tag",   "sync",   "data",  "cloud",
+        "view", "ads",   "promo", "count","lytic", "rtb",    "bid",   "push"};
+    static constexpr std::string_view TLDS[] = {
+        "com", "net", "org", "io", "de", "co.uk", "info", "xyz", "fr", "ru"};
+    static constexpr std::string_view SUBDOMAINS[] = {
+        "www", "cdn", "static", "img", "api", "s1", "s2", "eu", "us", "m"};
+    static constexpr std::string_view PATHS[] = {
+        "ads", "banner", "track", "pixel.gif", "beacon.js", "adserver", "pagead",
+        "sponsor", "analytics.js", "collect", "impression", "popunder", "widget"};
+    static constexpr std::string_view TYPES[] = {
+        "script", "image", "stylesheet", "xmlhttprequest", "xhr", "subdocument",
+        "media", "font", "websocket", "ping", "other", "document"};
+    static constexpr std::string_view FLAGS[] = {
+        "third-party", "3p", "first-party", "important", "match-case", "popup"};
+    static constexpr std::string_view METHODS[] = {"get", "post", "head", "put", "delete"};
+    static constexpr std::string_view SELECTORS[] = {
+        ".ad-banner", "#ad_container", ".sponsored", "div[id^=\"ad-\"]",
+        ".adsbygoogle", "iframe[src*=\"ads\"]", ".promo-box", "aside.ad"};
+
+    // splitmix64
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    uint64_t below(uint64_t n) { return next() % n; }
+    bool     chance(unsigned percent) { return below(100) < percent; }
+
+    template <size_t N>
+    std::string_view pick(const std::string_view (&table)[N]) { return table[below(N)]; }
+
+    void number(std::string &out, uint64_t n) {
+        char       buf[24];
+        const auto res = std::to_chars(buf, buf + sizeof buf, n);
+        out.append(buf, res.ptr);
+    }
+
+    std::string base_domain() {
+        std::string d(pick(SYLLABLES));
+        d += pick(SYLLABLES);
+        if (chance(70)) number(d, below(10000));
+        d += '.';
+        d += pick(TLDS);
+        return d;
+    }
+
+    // Hostname, zu 25 % aus dem heißen Pool, zu 20 % mit Subdomain
+    void host(std::string &out) {
+        if (chance(20)) {
+            out += pick(SUBDOMAINS);
+            out += '.';
+        }
+        if (chance(25)) out += hot_[below(hot_.size())];
+        else            out += base_domain();
+    }
+
+    void url_path(std::string &out) {
+        const uint64_t depth = 1 + below(3);
+        for (uint64_t i = 0; i < depth; ++i) {
+            out += '/';
+            out += pick(PATHS);
+        }
+    }
+
+    void bare(std::string &out) {
+        out += "||";
+        host(out);
+        out += '^';
+    }
+
+    void path(std::string &out) {
+        switch (below(4)) {
+            case 0:  out += "||"; host(out); url_path(out); if (chance(50)) out += '^'; break;
+            case 1:  out += "|https://"; host(out); url_path(out); out += '|'; break;
+            case 2:  url_path(out); out += '*'; out += pick(PATHS); break;
+            default: out += "&"; out += pick(PATHS); out += "_id="; break;
+        }
+    }
+
+    void regex(std::string &out) {
+        switch (below(4)) {
+            case 0:  out += "/^https?:\\/\\/"; out += pick(SYLLABLES); out += "[0-9]+\\.";
+                     out += pick(TLDS); out += "\\//"; break;
+            case 1:  out += "/\\/"; out += pick(PATHS); out += "\\/[a-z0-9]{8,}\\.js/"; break;
+            case 2:  out += "/"; out += pick(SYLLABLES); out += "-(banner|ad|pixel)\\.(gif|png)/"; break;
+            default: out += "/\\."; out += pick(SYLLABLES); out += "\\.com\\/"; out += pick(PATHS); out += "/"; break;
+        }
+    }
+
+    void allow(std::string &out) {
+        out += "@@";
+        switch (below(3)) {
+            case 0:  out += "||"; host(out); out += '^'; break;
+            case 1:  out += "||"; host(out); url_path(out); out += "$script,domain=";
+                     host(out); break;
+            default: out += "|https://"; host(out); out += '/'; break;
+        }
+    }
+
+    void domain_list(std::string &out, uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            if (i) out += '|';
+            if (chance(15)) out += '~';
+            host(out);
+        }
+    }
+
+    void options(std::string &out) {
+        if (chance(70)) { out += "||"; host(out); out += '^'; }
+        else            url_path(out);
+        out += '$';
+
+        // Optionen einsammeln und in zufälliger Reihenfolge ausgeben
+        std::vector<std::string> opts;
+        const uint64_t types = below(4);
+        for (uint64_t i = 0; i < types; ++i) {
+            std::string &t = opts.emplace_back(chance(20) ? "~" : "");
+            t += pick(TYPES);
+        }
+        if (chance(60)) opts.emplace_back(pick(FLAGS));
+        if (chance(55)) {
+            std::string d = "domain=";
+            domain_list(d, 1 + below(chance(20) ? 60 : 6));
+            opts.push_back(std::move(d));
+        }
+        if (chance(8)) {
+            std::string d = "domains=";
+            domain_list(d, 1 + below(4));
+            opts.push_back(std::move(d));
+        }
+        if (chance(6)) {
+            std::string m = chance(25) ? "~method=" : "method=";
+            m += pick(METHODS);
+            if (chance(50)) { m += '|'; m += pick(METHODS); }
+            opts.push_back(std::move(m));
+        }
+        if (opts.empty()) opts.emplace_back("third-party");
+        for (size_t i = opts.size(); i > 1; --i) std::swap(opts[i - 1], opts[below(i)]);
+        for (size_t i = 0; i < opts.size(); ++i) {
+            if (i) out += ',';
+            out += opts[i];
+        }
+    }
+
+    void cosmetic(std::string &out) {
+        if (chance(60)) host(out);
+        switch (below(4)) {
+            case 0:
+            case 1:  out += "##"; break;
+            case 2:  out += "#@#"; break;
+            default: out += "#?#"; break;
+        }
+        out += pick(SELECTORS);
+    }
+
+    void comment(std::string &out) {
+        switch (below(5)) {
+            case 0:  out += "[Adblock Plus 2.0]"; break;
+            case 1:  break;                                          // Leerzeile
+            case 2:  out += "! Homepage: https://"; host(out); break;
+            default: out += "! ---------- "; out += pick(PATHS); out += " ----------"; break;
+        }
+    }
+
+    // Frühere Regel, teils mit Leerraum oder umgedrehter Optionsreihenfolge
+    void dup(std::string &out) {
+        if (recent_.empty()) return bare(out);
+        const std::string &prev = recent_[below(recent_.size())];
+        const size_t       dollar = prev.find('$');
+        switch (below(3)) {
+            case 0:  out += prev; break;
+            case 1:  out += "  "; out += prev; out += ' '; break;
+            default:
+                if (dollar == std::string::npos) { out += prev; break; }
+                out.append(prev, 0, dollar + 1);
+                {
+                    std::vector<std::string_view> parts;
+                    std::string_view              rest = std::string_view(prev).substr(dollar + 1);
+                    for (size_t c; (c = rest.find(',')) != std::string_view::npos; rest.remove_prefix(c + 1))
+                        parts.push_back(rest.substr(0, c));
+                    parts.push_back(rest);
+                    for (size_t i = parts.size(); i-- > 0;) {
+                        out += parts[i];
+                        if (i) out += ',';
+                    }
+                }
+                break;
+        }
+    }
+
+    void remember(std::string_view rule) {
+        constexpr size_t RING = 4096;
+        if (recent_.size() < RING) recent_.emplace_back(rule);
+        else                       recent_[ringPos_++ % RING].assign(rule);
+    }
+
+    uint64_t                 state_;
+    ListMix                  mix_;
+    unsigned                 total_ = 0;
+    std::vector<std::string> hot_;
+    std::vector<std::string> recent_;
+    size_t                   ringPos_ = 0;
+};
@@ -0,0 +1,533 @@
+/***********************************************************************
+ *  matchcheck – Gegenprobe der Optimierungs-Pässe über den Matcher
+ *
+ *  Aufruf:  build/matchcheck [--requests N] [--seed S] [--max-domains N]
+ *                            liste.txt [...]
+ *
+ *  Parst die Listen einmal roh (nur ohne regexFilter, die Chrome
+ *  ablehnen würde) und einmal durch alle Pässe (optimize_rules) und
+ *  schickt zufällige Requests durch beide Regelsätze.  Hosts und
+ *  Pfadstücke stammen aus den Regeln selbst, damit ein guter Teil der
+ *  Requests trifft.  Geprüft wird, dass
+ *    – der Index dieselbe Regel liefert wie der lineare Durchlauf,
+ *    – der optimierte Satz dieselbe Aktion wählt wie der rohe,
+ *    – url_filter_matches mit dem Referenz-Matcher übereinstimmt,
+ *    – die urlFilter, zu denen lower_regex_rules einen regexFilter
+ *      umschreibt, dieselben URLs treffen wie std::regex mit dem
+ *      Original (auch auf URLs, die aus dem Muster gebaut sind) und
+ *    – RegexSet (regex_dfa.h) für die regexFilter der Listen dasselbe
+ *      findet wie std::regex (ebenso auf URLs aus den Mustern).
+ *  Dazu Abfragen pro Sekunde mit und ohne Index.  Abweichungen landen
+ *  auf stderr, der Exit-Code ist dann 1.
+ ***********************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "matcher.h"
+#include "optimize.h"
+#include "parser.h"
+#include "regex.h"
+#include "regex_dfa.h"
+#include "urlfilter_ref.h"
+
+// splitmix64 – deterministisch auf jeder Plattform
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z          = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+
+    template <typename T>
+    const T &pick(const std::vector<T> &items) { return items[below(items.size())]; }
+    template <size_t N>
+    std::string_view pick(const std::string_view (&items)[N]) { return items[below(N)]; }
+
+private:
+    uint64_t state_;
+};
+
+struct Request {
+    std::string  url;
+    std::string  initiator;
+    ResourceType type;
+    std::string  method;
+};
+
+static constexpr std::string_view SCHEMES[]    = {"https://", "http://", "wss://"};
+static constexpr std::string_view SUBDOMAINS[] = {"www.", "cdn.", "ads.", "a.b."};
+static constexpr std::string_view PORTS[]      = {":8080", ":443", ":1"};
+static constexpr std::string_view TOKENS[]     = {"ad", "ads", "banner", "track", "js", "img", "pixel",
+                                                  "1", "x", "-", "_", ".", "/", "?", "=", "&"};
+static constexpr std::string_view METHODS[]    = {"GET", "GET", "POST", "HEAD", "put", "OPTIONS", "delete"};
+
+static std::string read_file(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "matchcheck: cannot open %s\n", path);
+        std::exit(1);
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Host hinter "||" bis zum ersten Nicht-Host-Zeichen, sonst leer
+static std::string_view anchored_host(std::string_view filter) {
+    if (!filter.starts_with("||")) return {};
+    filter.remove_prefix(2);
+    const size_t end = filter.find_first_not_of("abcdefghijklmnopqrstuvwxyz0123456789-._");
+    return filter.substr(0, end);
+}
+
+// Musterrumpf als URL-Stück: Platzhalter ersetzt, Anker entfernt
+static std::string fragment_for(std::string_view filter, Rng &rng) {
+    while (filter.starts_with('|')) filter.remove_prefix(1);
+    if (filter.ends_with('|')) filter.remove_suffix(1);
+    std::string f;
+    for (const char c : filter) {
+        if (c == '*')      f += rng.pick(TOKENS);
+        else if (c == '^') f += rng.below(2) ? "/" : "?";
+        else               f += c;
+    }
+    return f;
+}
+
+// Zufälliger Text, den Teilbaum n trifft; Zusicherungen bleiben außen
+// vor (wo sie nicht passen, trifft das Muster eben nicht)
+static void regex_sample(const RegexAst &ast, uint32_t n, Rng &rng, std::string &out) {
+    const RegexNode &node = ast[n];
+    switch (node.kind) {
+    case RegexKind::Literal:
+        out += node.icase && rng.below(2) ? char(std::toupper(static_cast<unsigned char>(node.ch))) : node.ch;
+        break;
+    case RegexKind::AnyChar:
+    case RegexKind::Class: {
+        // Druckbares ASCII bevorzugt, ab zufälliger Stelle gesucht
+        const size_t start = rng.below(256);
+        int          pick  = -1;
+        for (size_t k = 0; k < 256 * 2 && pick < 0; ++k) {
+            const size_t c = (start + k) % 256;
+            if (node.set.test(c) && (k >= 256 || (c > 0x20 && c < 0x7F))) pick = int(c);
+        }
+        if (pick >= 0) out += char(pick);
+        break;
+    }
+    case RegexKind::Concat:
+        for (const uint32_t k : node.kids) regex_sample(ast, k, rng, out);
+        break;
+    case RegexKind::Alternate:
+        regex_sample(ast, node.kids[rng.below(node.kids.size())], rng, out);
+        break;
+    case RegexKind::Repeat: {
+        const int extra = node.max < 0 ? 2 : std::min(node.max - node.min, 2);
+        for (int k = node.min + int(rng.below(size_t(extra) + 1)); k > 0; --k)
+            regex_sample(ast, node.kids[0], rng, out);
+        break;
+    }
+    case RegexKind::Group:
+        regex_sample(ast, node.kids[0], rng, out);
+        break;
+    default:
+        break;
+    }
+}
+
+// URL, die regexFilter pattern wahrscheinlich trifft: ein Beispieltext
+// des Musters als ganze URL (bei '^') oder im Pfad einer URL; leer,
+// wenn parse_regex das Muster ablehnt
+static std::string url_for_regex(std::string_view pattern, Rng &rng) {
+    const RegexAst ast = parse_regex(pattern);
+    if (ast.error != RegexError::None) return {};
+    std::string url;
+    if (!pattern.starts_with('^')) {
+        url = std::string(rng.pick(SCHEMES)) + "example.org/";
+        if (rng.below(2)) url += rng.pick(TOKENS);
+    }
+    regex_sample(ast, ast.root, rng, url);
+    if (!pattern.ends_with('$') && rng.below(2)) url += rng.pick(TOKENS);
+    return url;
+}
+
+static Request random_request(Rng &rng, const std::vector<std::string> &hosts,
+                              const std::vector<std::string_view> &filters) {
+    Request r;
+    r.url = rng.pick(SCHEMES);
+    if (rng.below(3) == 0) r.url += rng.pick(SUBDOMAINS);
+    r.url += rng.below(8) ? std::string_view(rng.pick(hosts)) : std::string_view("example.org");
+    if (rng.below(8) == 0) r.url += rng.pick(PORTS);                // "||host/" trifft hier nicht
+    r.url += '/';
+    for (size_t n = rng.below(4); n > 0; --n) r.url += rng.pick(TOKENS);
+    if (!filters.empty() && rng.below(2)) r.url += fragment_for(rng.pick(filters), rng);
+    if (rng.below(2)) r.url += rng.pick(TOKENS);
+
+    if (rng.below(3))
+        r.initiator = "https://" + (rng.below(2) ? rng.pick(hosts) : std::string("example.org"));
+    r.type   = static_cast<ResourceType>(rng.below(size_t(ResourceType::Count)));
+    r.method = rng.pick(METHODS);
+    return r;
+}
+
+static bool same_action(const DnrRule *a, const DnrRule *b) {
+    if (!a || !b) return a == b;
+    return a->actionType == b->actionType;
+}
+
+static const char *describe(const DnrRule *r) { return r ? r->actionType.data() : "none"; }
+
+template <typename Fn>
+static double per_second(size_t count, Fn &&fn) {
+    using clock  = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    fn();
+    return count / std::chrono::duration<double>(clock::now() - t0).count();
+}
+
+static std::string random_label(Rng &rng) {
+    std::string l;
+    for (size_t n = 3 + rng.below(8); n > 0; --n) l += char('a' + rng.below(26));
+    return l;
+}
+
+// Host-Index allein: domainCount zufällige Domains, Abfragen auf
+// bekannte und unbekannte Hosts mit bis zu zwei Subdomain-Labels.
+// Prüft jede Abfrage gegen eine unordered_map; liefert die Zahl der
+// Abweichungen.
+static size_t check_host_index(Rng &rng, size_t domainCount) {
+    static constexpr std::string_view TLDS[] = {"com", "net", "org", "de", "io", "co.uk"};
+    DomainTable                                  domains;
+    std::unordered_map<std::string, DomainId>    known;
+    std::vector<std::string>                     names;
+    while (domains.size() < domainCount) {
+        std::string d = random_label(rng) + "." + std::string(rng.pick(TLDS));
+        if (rng.below(4) == 0) d = random_label(rng) + "." + d;
+        known.emplace(d, domains.intern(d));
+        names.push_back(std::move(d));
+    }
+    HostSuffixIndex index;
+    index.build(domains);
+
+    // Hosts hintereinander in einem Puffer, wie sie in der klein
+    // geschriebenen URL einer Abfrage liegen
+    std::string                   pool;
+    std::vector<std::string_view> hosts(1 << 20);
+    std::vector<size_t>           ends;
+    for (size_t k = 0; k < hosts.size(); ++k) {
+        for (size_t n = rng.below(3); n > 0; --n) pool += random_label(rng) + ".";
+        pool += rng.below(3) ? rng.pick(names) : random_label(rng) + "." + std::string(rng.pick(TLDS));
+        ends.push_back(pool.size());
+    }
+    for (size_t k = 0; k < hosts.size(); ++k) {
+        const size_t begin = k ? ends[k - 1] : 0;
+        hosts[k]           = std::string_view(pool).substr(begin, ends[k] - begin);
+    }
+
+    size_t   mismatches = 0, found = 0;
+    DomainId ids[32];
+    for (const std::string_view h : hosts) {
+        std::vector<DomainId> want;
+        for (size_t i = h.size(); i-- > 0;) {
+            if (i > 0 && h[i - 1] != '.') continue;
+            if (const auto it = known.find(std::string(h.substr(i))); it != known.end())
+                want.push_back(it->second);
+        }
+        const size_t n = index.lookup(h, ids, std::size(ids));
+        found += n;
+        if (std::vector<DomainId>(ids, ids + n) != want && ++mismatches <= 20)
+            std::fprintf(stderr, "host index: %.*s: %zu suffixes found, %zu expected\n", int(h.size()),
+                         h.data(), n, want.size());
+    }
+
+    // Bester von fünf Durchläufen
+    size_t hits = 0;
+    double rate = 0;
+    for (int run = 0; run < 5; ++run) {
+        hits = 0;
+        rate = std::max(rate, per_second(hosts.size(), [&] {
+            for (const std::string_view h : hosts) hits += index.lookup(h, ids, std::size(ids));
+        }));
+    }
+    std::printf("host index: %zu domains, %zu lookups (%zu suffix hits), %.1f M lookups/s\n", domains.size(),
+                hosts.size(), found, rate / 1e6);
+    return mismatches + (hits != found);
+}
+
+// regexFilter → urlFilter: jede Regel für sich durch lower_regex_rules;
+// die urlFilter müssen zusammen genau die URLs treffen, die std::regex
+// mit dem Original trifft – auf URLs, die aus dem Muster gebaut sind,
+// und auf Requests des Stapels.  Trifft keine einzige URL, ist nichts
+// bewiesen, und das zählt als Abweichung.  Liefert die Zahl der
+// Abweichungen.
+static size_t check_lowering(const std::vector<DnrRule> &rules, const std::vector<Request> &batch, Rng &rng) {
+    RuleArena                            arena;
+    std::unordered_set<std::string_view> seen;
+    size_t                               lowered = 0, compared = 0, matched = 0, mismatches = 0;
+    for (const DnrRule &r : rules) {
+        if (!r.conditionRegexFilter || r.conditionUrlFilter || !seen.insert(*r.conditionRegexFilter).second)
+            continue;
+        std::vector<DnrRule> variants{r};
+        if (!lower_regex_rules(variants, arena)) continue;
+        const std::string_view p = *r.conditionRegexFilter;
+        std::regex             re;
+        try {
+            re = std::regex(p.begin(), p.end(),
+                            std::regex::ECMAScript | std::regex::icase | std::regex::nosubs);
+        } catch (const std::regex_error &) {
+            continue;
+        }
+        ++lowered;
+        for (size_t k = 0; k < 6; ++k) {
+            if (k >= 3 && batch.empty()) break;
+            const std::string url  = k < 3 ? url_for_regex(p, rng) : batch[rng.below(batch.size())].url;
+            const bool        want = std::regex_search(url, re);
+            bool              got  = false;
+            for (const DnrRule &v : variants) got = got || url_filter_matches(*v.conditionUrlFilter, url);
+            ++compared;
+            matched += want;
+            if (got != want && ++mismatches <= 20)
+                std::fprintf(stderr, "lowered regexFilter %.*s on %s: std::regex %s\n", int(p.size()),
+                             p.data(), url.c_str(), want ? "matches" : "misses");
+        }
+    }
+    std::printf("regex lowering: %zu distinct regexFilter lowered, %zu comparisons (%zu matches)\n", lowered,
+                compared, matched);
+    if (lowered && !matched) {
+        std::fprintf(stderr, "regex lowering: no URL matched, nothing was checked\n");
+        ++mismatches;
+    }
+    return mismatches;
+}
+
+// regexFilter allein: ein RegexSet über alle regexFilter der Regeln
+// gegen std::regex (ECMAScript, case-insensitiv) auf den ersten URLs
+// des Stapels und auf URLs aus Beispieltexten zufälliger Muster (sonst
+// träfe kaum eine, und der Literal-Vorfilter liefe nie bis zur DFA);
+// was std::regex nicht übersetzt, fällt aus dem Abgleich.  Trifft
+// keine URL, gilt das als Abweichung.  Dazu alle Muster je URL pro
+// Sekunde mit beiden.  Liefert die Zahl der Abweichungen.
+static size_t check_regex_set(const std::vector<DnrRule> &rules, const std::vector<Request> &batch,
+                              Rng &rng) {
+    RegexSet                      set;
+    std::vector<std::string_view> patterns;
+    std::vector<std::regex>       reference;
+    std::vector<char>             usable;
+    for (const DnrRule &r : rules) {
+        if (!r.conditionRegexFilter || set.add(*r.conditionRegexFilter) < 0) continue;
+        const std::string_view p = *r.conditionRegexFilter;
+        patterns.push_back(p);
+        try {
+            reference.emplace_back(p.begin(), p.end(), std::regex::ECMAScript | std::regex::icase |
+                                                           std::regex::nosubs | std::regex::optimize);
+            usable.push_back(1);
+        } catch (const std::regex_error &) {
+            reference.emplace_back();
+            usable.push_back(0);
+        }
+    }
+    if (patterns.empty()) return 0;
+    set.build();
+
+    std::vector<std::string> urlList;
+    for (size_t n = 0; n < std::min<size_t>(batch.size(), 100); ++n) urlList.push_back(batch[n].url);
+    for (size_t n = 0; n < 100; ++n)
+        if (std::string url = url_for_regex(patterns[rng.below(patterns.size())], rng); !url.empty())
+            urlList.push_back(std::move(url));
+
+    const size_t          urls = urlList.size();
+    std::vector<char>     want(urls * patterns.size());
+    std::vector<uint64_t> hits;
+    const double          referenceRate = per_second(urls, [&] {
+        for (size_t n = 0; n < urls; ++n)
+            for (size_t i = 0; i < patterns.size(); ++i)
+                if (usable[i]) want[n * patterns.size() + i] = std::regex_search(urlList[n], reference[i]);
+    });
+
+    size_t compared = 0, matched = 0, mismatches = 0;
+    for (size_t n = 0; n < urls; ++n) {
+        set.search(urlList[n], hits);
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            if (!usable[i]) continue;
+            const bool expected = want[n * patterns.size() + i];
+            ++compared;
+            matched += expected;
+            if ((hits[i / 64] >> (i % 64) & 1) != expected && ++mismatches <= 20)
+                std::fprintf(stderr, "regexFilter %.*s on %s: std::regex %s\n", int(patterns[i].size()),
+                             patterns[i].data(), urlList[n].c_str(), expected ? "matches" : "misses");
+        }
+    }
+
+    size_t       sink    = 0;
+    const double setRate = per_second(urls, [&] {
+        for (size_t n = 0; n < urls; ++n) {
+            set.search(urlList[n], hits);
+            sink += hits[0] & 1;
+        }
+    });
+    const RegexSetStats s = set.stats();
+    std::printf("regexFilter: %zu patterns (%zu prefiltered, %zu programs, %zu DFA states, %zu unchecked), "
+                "%zu comparisons (%zu matches)\n",
+                s.patterns, s.prefiltered, s.programs, s.states, patterns.size() - compared / urls, compared,
+                matched);
+    std::printf("regexFilter: all patterns per URL %.0f/s RegexSet, %.0f/s std::regex (%zu)\n", setRate,
+                referenceRate, sink);
+    if (compared && !matched) {
+        std::fprintf(stderr, "regexFilter: no URL matched, the DFAs were never checked\n");
+        ++mismatches;
+    }
+    return mismatches;
+}
+
+static void print_stats(const char *name, size_t rules, const MatcherStats &s) {
+    std::printf("%-9s %8zu rules: %zu host-indexed, %zu initiator-indexed, %zu token-indexed, %zu generic, "
+                "%zu regex (%zu not compiled)\n",
+                name, rules, s.hostIndexed, s.initiatorIndexed, s.tokenIndexed, s.generic, s.regex, s.badRegex);
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: matchcheck [--requests N] [--seed S] [--max-domains N] list.txt [...]\n");
+    std::exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t                    requests = 20000;
+    uint64_t                  seed     = 1;
+    OptimizeOptions           options;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--requests" && i + 1 < argc)  requests = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--seed" && i + 1 < argc) seed     = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--max-domains" && i + 1 < argc)
+            options.maxRequestDomains = std::strtoull(argv[++i], nullptr, 10);
+        else if (a.starts_with('-'))            usage();
+        else                                    files.push_back(argv[i]);
+    }
+    if (files.empty()) usage();
+
+    std::string text;
+    for (const char *f : files) {
+        text += read_file(f);
+        if (!text.empty() && text.back() != '\n') text.push_back('\n');
+    }
+
+    // Roh: Zeilennummer als ID wie vor assign_ids
+    RuleArena            arena;
+    std::vector<DnrRule> raw;
+    int                  line = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        if (auto r = parse_line(std::string_view(text).substr(pos, end - pos), ++line, arena))
+            raw.push_back(*r);
+        pos = end + 1;
+    }
+    drop_unsupported_regex_rules(raw, nullptr);
+
+    std::vector<DnrRule> optimized = raw;
+    OptimizeStats        stats;
+    optimize_rules(optimized, arena, options, stats);
+
+    const RuleMatcher rawMatcher(raw, arena.domains());
+    const RuleMatcher optMatcher(optimized, arena.domains());
+    print_stats("raw", raw.size(), rawMatcher.stats());
+    print_stats("optimized", optimized.size(), optMatcher.stats());
+
+    // Request-Zutaten aus den Regeln
+    std::vector<std::string>      hosts;
+    std::vector<std::string_view> filters;          // generische urlFilter
+    const DomainTable            &domains = arena.domains();
+    for (const DnrRule &r : raw) {
+        for (const DomainList list : {r.conditionRequestDomains, r.conditionInitiatorDomains})
+            for (const DomainId d : list) hosts.emplace_back(domains[d]);
+        if (!r.conditionUrlFilter) continue;
+        if (const std::string_view h = anchored_host(*r.conditionUrlFilter); !h.empty())
+            hosts.emplace_back(h);
+        else if (!r.conditionUrlFilter->starts_with("||"))
+            filters.push_back(*r.conditionUrlFilter);
+    }
+    if (hosts.empty()) hosts.emplace_back("example.com");
+
+    Rng                  rng(seed);
+    std::vector<Request> batch;
+    batch.reserve(requests);
+    for (size_t n = 0; n < requests; ++n) batch.push_back(random_request(rng, hosts, filters));
+
+    size_t    matched = 0, mismatches = 0;
+    MatchCost rawCost, optCost;
+    auto report = [&](const char *what, const Request &q, const char *a, const char *b) {
+        if (++mismatches <= 20)
+            std::fprintf(stderr, "%s: %s (initiator \"%s\", %s, %s): %s vs %s\n", what, q.url.c_str(),
+                         q.initiator.c_str(), ALL_DNR_RESOURCE_TYPES[size_t(q.type)].data(),
+                         q.method.c_str(), a, b);
+    };
+    for (const Request &q : batch) {
+        const DnrRule *indexed = rawMatcher.match(q.url, q.initiator, q.type, q.method, rawCost);
+        const DnrRule *linear  = rawMatcher.match_linear(q.url, q.initiator, q.type, q.method);
+        const DnrRule *opt     = optMatcher.match(q.url, q.initiator, q.type, q.method, optCost);
+        if (indexed) ++matched;
+        if (indexed != linear) report("index", q, describe(indexed), describe(linear));
+        if (!same_action(indexed, opt)) report("optimized", q, describe(indexed), describe(opt));
+    }
+
+    // urlFilter-Abgleich gegen die Referenz auf einer Stichprobe
+    size_t compared = 0;
+    for (size_t n = 0; n < std::min<size_t>(requests, 2000) && !filters.empty(); ++n) {
+        const std::string_view filter = rng.pick(filters);
+        const std::string     &url    = batch[n].url;
+        const bool             want   = urlfilter_ref::matches(filter, url);
+        ++compared;
+        if (url_filter_matches(filter, url) != want) {
+            if (++mismatches <= 20)
+                std::fprintf(stderr, "urlFilter %.*s on %s: reference %s\n", int(filter.size()),
+                             filter.data(), url.c_str(), want ? "matches" : "misses");
+        }
+    }
+
+    size_t       hits    = 0;                   // hält den Optimierer von den Aufrufen fern
+    const double indexed = per_second(batch.size(), [&] {
+        for (const Request &q : batch)
+            hits += rawMatcher.match(q.url, q.initiator, q.type, q.method) != nullptr;
+    });
+    const double optimizedRate = per_second(batch.size(), [&] {
+        for (const Request &q : batch)
+            hits += optMatcher.match(q.url, q.initiator, q.type, q.method) != nullptr;
+    });
+    const size_t linearCount = std::min<size_t>(batch.size(), 2000);
+    const double linear      = per_second(linearCount, [&] {
+        for (size_t n = 0; n < linearCount; ++n) {
+            const Request &q = batch[n];
+            hits += rawMatcher.match_linear(q.url, q.initiator, q.type, q.method) != nullptr;
+        }
+    });
+
+    mismatches += check_lowering(raw, batch, rng);
+    mismatches += check_regex_set(raw, batch, rng);
+    mismatches += check_host_index(rng, 100000);
+
+    std::printf("matchcheck: %zu requests (%zu matched), %zu urlFilter comparisons, %zu mismatches\n",
+                batch.size(), matched, compared, mismatches);
+    const double n = double(batch.size());
+    std::printf("per request: raw %.1f candidates (%.1f verified), optimized %.1f (%.1f), linear %zu\n",
+                rawCost.candidates / n, rawCost.verified / n, optCost.candidates / n, optCost.verified / n,
+                raw.size());
+    std::printf("throughput: %.0f queries/s indexed, %.0f optimized, %.0f linear (first %zu requests, "
+                "%zu hits)\n",
+                indexed, optimizedRate, linear, linearCount, hits);
+    return mismatches ? 1 : 0;
+}
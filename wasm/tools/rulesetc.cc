@@ -0,0 +1,186 @@
+/***********************************************************************
+ *  rulesetc – statische DNR-Rulesets für manifest.json erzeugen
+ *
+ *  Aufruf:  build/rulesetc [--max-domains N] [--ruleset-size N]
+ *                          [--enabled-rules N] [--prefix pfad]
+ *                          -o verzeichnis liste.txt [...]
+ *
+ *  Jede Liste ist eine Kategorie (Name = Dateiname ohne Endung).  Ihre
+ *  Regeln landen in rule_resources-Dateien <kategorie>[_n].json mit
+ *  höchstens --ruleset-size Regeln (Standard: GUARANTEED_MINIMUM_STATIC_
+ *  RULES); regexFilter-Regeln bekommen eigene Rulesets
+ *  <kategorie>_regex[_n] mit höchstens MAX_REGEX_RULES Einträgen.
+ *  allow-Regeln stehen vorn im ersten Ruleset ihrer Kategorie und sind
+ *  damit aktiv, sobald irgendein Teil der Kategorie es ist.
+ *
+ *  Aktiviert werden Rulesets in Reihenfolge, solange die Zahl aktiver
+ *  Rulesets und --enabled-rules (Standard wie oben) reichen; der Rest
+ *  steht mit "enabled": false im Manifest.  Auf stdout steht der
+ *  "declarative_net_request"-Abschnitt, --prefix ist das Verzeichnis
+ *  der Dateien relativ zu manifest.json (Standard "rulesets").
+ ***********************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+#include "optimize.h"
+#include "parser.h"
+
+// Chromes Grenzen für statische Rulesets (chrome.declarativeNetRequest.*)
+constexpr size_t MAX_NUMBER_OF_STATIC_RULESETS         = 100;
+constexpr size_t MAX_NUMBER_OF_ENABLED_STATIC_RULESETS = 50;
+constexpr size_t GUARANTEED_MINIMUM_STATIC_RULES       = 30000;
+constexpr size_t MAX_REGEX_RULES                       = 1000;
+
+struct Ruleset {
+    std::string id;
+    std::string json;           // Dateiinhalt
+    size_t      rules   = 0;
+    bool        enabled = false;
+};
+
+static std::string read_file(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "rulesetc: cannot open %s\n", path);
+        std::exit(1);
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: rulesetc [--max-domains N] [--ruleset-size N] [--enabled-rules N] "
+                         "[--prefix path] -o dir list.txt [...]\n");
+    std::exit(2);
+}
+
+// Ruleset-IDs: Buchstaben, Ziffern, '_' und '-', nicht mit '_' beginnend
+// (von Chrome reserviert) und eindeutig
+static std::string category_name(const char *path, std::unordered_set<std::string> &used) {
+    std::string name = std::filesystem::path(path).stem().string();
+    for (char &c : name) {
+        const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                        c == '-' || c == '_';
+        if (!ok) c = '_';
+    }
+    if (name.empty() || name.front() == '_') name.insert(0, "list");
+    std::string unique = name;
+    for (int n = 2; !used.insert(unique).second; ++n) unique = name + "_" + std::to_string(n);
+    return unique;
+}
+
+// Verteilt rules (Domains aus domains) in Blöcken zu höchstens perSet
+// Regeln auf Rulesets base, base_2, ...; IDs beginnen je Ruleset bei 1
+static void split_rulesets(std::vector<Ruleset> &out, const std::string &base,
+                           const std::vector<const DnrRule *> &rules, const DomainTable &domains,
+                           size_t perSet) {
+    const size_t sets = (rules.size() + perSet - 1) / perSet;
+    for (size_t s = 0; s < sets; ++s) {
+        Ruleset set;
+        set.id = s == 0 ? base : base + "_" + std::to_string(s + 1);
+        const size_t begin = s * perSet, end = std::min(rules.size(), begin + perSet);
+        set.json.reserve((end - begin) * 96 + 2);
+        set.json.push_back('[');
+        for (size_t i = begin; i < end; ++i) {
+            DnrRule r = *rules[i];
+            r.id      = static_cast<int>(i - begin + 1);
+            if (i != begin) set.json.push_back(',');
+            write_rule_json(set.json, r, domains);
+        }
+        set.json.push_back(']');
+        set.rules = end - begin;
+        out.push_back(std::move(set));
+    }
+}
+
+int main(int argc, char **argv) {
+    OptimizeOptions           options;
+    size_t                    rulesetSize  = GUARANTEED_MINIMUM_STATIC_RULES;
+    size_t                    enabledRules = GUARANTEED_MINIMUM_STATIC_RULES;
+    std::string               prefix       = "rulesets";
+    const char               *outDir       = nullptr;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--max-domains" && i + 1 < argc)
+            options.maxRequestDomains = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--ruleset-size" && i + 1 < argc)
+            rulesetSize = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--enabled-rules" && i + 1 < argc)
+            enabledRules = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--prefix" && i + 1 < argc) prefix = argv[++i];
+        else if (a == "-o" && i + 1 < argc)       outDir = argv[++i];
+        else if (a.starts_with('-'))              usage();
+        else                                      files.push_back(argv[i]);
+    }
+    if (files.empty() || !outDir || rulesetSize == 0) usage();
+
+    std::vector<Ruleset>            rulesets;
+    std::unordered_set<std::string> used;
+    for (const char *path : files) {
+        const std::string category = category_name(path, used);
+        const std::string text     = read_file(path);
+        OptimizeStats     stats;
+        const ParsedChunk chunk    = compileFilterList(text, options, stats);
+
+        std::vector<const DnrRule *> plain, regex;
+        for (const auto &r : chunk.rules)
+            if (!r.conditionRegexFilter && r.actionType == "allow") plain.push_back(&r);
+        for (const auto &r : chunk.rules) {
+            if (r.conditionRegexFilter)       regex.push_back(&r);
+            else if (r.actionType != "allow") plain.push_back(&r);
+        }
+        const DomainTable &domains = chunk.arena->domains();
+        split_rulesets(rulesets, category, plain, domains, rulesetSize);
+        split_rulesets(rulesets, category + "_regex", regex, domains,
+                       std::min(rulesetSize, MAX_REGEX_RULES));
+
+        std::fprintf(stderr, "rulesetc: %s: %d lines, %zu rules (%zu regex)\n", category.c_str(),
+                     chunk.totalLines, chunk.rules.size(), regex.size());
+    }
+    if (rulesets.size() > MAX_NUMBER_OF_STATIC_RULESETS) {
+        std::fprintf(stderr, "rulesetc: %zu rulesets exceed Chrome's limit of %zu\n",
+                     rulesets.size(), MAX_NUMBER_OF_STATIC_RULESETS);
+        return 1;
+    }
+
+    size_t enabledSets = 0, enabledTotal = 0;
+    for (auto &set : rulesets) {
+        if (enabledSets == MAX_NUMBER_OF_ENABLED_STATIC_RULESETS ||
+            enabledTotal + set.rules > enabledRules)
+            continue;
+        set.enabled = true;
+        ++enabledSets;
+        enabledTotal += set.rules;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(outDir, ec);
+    nlohmann::ordered_json resources = nlohmann::ordered_json::array();
+    for (const auto &set : rulesets) {
+        const auto file = std::filesystem::path(outDir) / (set.id + ".json");
+        std::ofstream os(file, std::ios::binary);
+        if (!os.write(set.json.data(), static_cast<std::streamsize>(set.json.size()))) {
+            std::fprintf(stderr, "rulesetc: cannot write %s\n", file.string().c_str());
+            return 1;
+        }
+        resources.push_back({{"id", set.id},
+                             {"enabled", set.enabled},
+                             {"path", prefix + "/" + set.id + ".json"}});
+        std::fprintf(stderr, "rulesetc: %-24s %6zu rules%s\n", set.id.c_str(), set.rules,
+                     set.enabled ? "" : "  (disabled)");
+    }
+
+    nlohmann::ordered_json stanza;
+    stanza["declarative_net_request"]["rule_resources"] = std::move(resources);
+    std::printf("%s\n", stanza.dump(2).c_str());
+    return 0;
+}
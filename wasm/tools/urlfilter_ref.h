@@ -0,0 +1,92 @@
+/***********************************************************************
+ *  Referenz-Matcher für urlFilter (Chrome-DNR-Semantik)
+ *
+ *  Absichtlich naiv: Abgleich direkt auf dem Muster, ohne Index und
+ *  ohne Vorverarbeitung, damit er als Orakel für die Werkzeuge taugt,
+ *  die schnellere oder umgeschriebene Varianten prüfen.
+ *
+ *  Semantik wie chrome.declarativeNetRequest ohne
+ *  isUrlFilterCaseSensitive (Groß-/Kleinschreibung egal):
+ *    '*'   beliebig viele Zeichen
+ *    '^'   ein Trennzeichen (weder Buchstabe noch Ziffer noch '_', '-',
+ *          '.', '%') oder das URL-Ende
+ *    '|'   am Anfang bzw. Ende: Anker an URL-Anfang bzw. -Ende
+ *    '||'  am Anfang: Anker am Host-Anfang oder hinter einem '.' im Host
+ ***********************************************************************/
+
+#pragma once
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace urlfilter_ref {
+
+inline char lower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c; }
+
+inline bool is_separator(char c) {
+    const char l = lower(c);
+    return !((l >= 'a' && l <= 'z') || (l >= '0' && l <= '9') || l == '_' || l == '-' || l == '.' ||
+             l == '%');
+}
+
+// Host als [begin, end) hinter "scheme://" (ohne Userinfo und Port)
+inline std::pair<size_t, size_t> host_range(std::string_view url) {
+    size_t begin = url.find("://");
+    if (begin == std::string_view::npos) return {0, 0};
+    begin += 3;
+    size_t end = url.find_first_of("/?#", begin);
+    if (end == std::string_view::npos) end = url.size();
+    const size_t at = url.substr(begin, end - begin).rfind('@');
+    if (at != std::string_view::npos) begin += at + 1;
+    const size_t colon = url.substr(begin, end - begin).find(':');
+    if (colon != std::string_view::npos) end = begin + colon;
+    return {begin, end};
+}
+
+// Trifft body ab url[start] (bei rightAnchor bis genau zum Ende)?
+// Tabelle über (Musterposition, URL-Position), damit '*' nicht
+// exponentiell zurückverfolgt.
+inline bool match_at(std::string_view body, std::string_view url, size_t start, bool rightAnchor) {
+    const size_t             w = url.size() + 1;
+    std::vector<signed char> memo((body.size() + 1) * w, -1);
+    auto rec = [&](auto &self, size_t p, size_t i) -> bool {
+        signed char &m = memo[p * w + i];
+        if (m >= 0) return m;
+        bool r;
+        if (p == body.size()) {
+            r = !rightAnchor || i == url.size();
+        } else if (body[p] == '*') {
+            r = self(self, p + 1, i) || (i < url.size() && self(self, p, i + 1));
+        } else if (body[p] == '^') {
+            r = i == url.size() ? self(self, p + 1, i)
+                                : is_separator(url[i]) && self(self, p + 1, i + 1);
+        } else {
+            r = i < url.size() && lower(url[i]) == lower(body[p]) && self(self, p + 1, i + 1);
+        }
+        m = r;
+        return r;
+    };
+    return rec(rec, 0, start);
+}
+
+inline bool matches(std::string_view filter, std::string_view url) {
+    bool domainAnchor = false, leftAnchor = false;
+    if (filter.starts_with("||"))     domainAnchor = true, filter.remove_prefix(2);
+    else if (filter.starts_with('|')) leftAnchor = true, filter.remove_prefix(1);
+    const bool rightAnchor = !filter.empty() && filter.back() == '|';
+    if (rightAnchor) filter.remove_suffix(1);
+
+    if (leftAnchor) return match_at(filter, url, 0, rightAnchor);
+    if (domainAnchor) {
+        const auto [begin, end] = host_range(url);
+        for (size_t i = begin; i < end; ++i)
+            if ((i == begin || url[i - 1] == '.') && match_at(filter, url, i, rightAnchor)) return true;
+        return false;
+    }
+    for (size_t i = 0; i <= url.size(); ++i)
+        if (match_at(filter, url, i, rightAnchor)) return true;
+    return false;
+}
+
+}  // namespace urlfilter_ref